@@ -0,0 +1,41 @@
+QT       += core gui widgets multimedia multimediawidgets concurrent
+
+greaterThan(QT_MAJOR_VERSION, 5): QT += multimedia quick
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+TARGET = PSvidio
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(../core.pri)
+
+SOURCES += \
+    ../fileviewsubwindow.cpp \
+    ../main.cpp \
+    ../mainwindow.cpp \
+    ../imageviewer.cpp \
+    ../batchprocessor.cpp \
+    ../videoprocessor.cpp \
+    ../videoexporter.cpp \
+    ../videoindexer.cpp
+
+HEADERS += \
+    ../fileviewsubwindow.h \
+    ../mainwindow.h \
+    ../imageviewer.h \
+    ../batchprocessor.h \
+    ../videoprocessor.h \
+    ../videoexporter.h \
+    ../videoindexer.h
+
+FORMS += \
+    ../mainwindow.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,198 @@
+#include "batchprocessor.h"
+#include "commandfactory.h"
+#include "imagecommand.h"
+#include "imageloader.h"
+#include "mappedimageio.h"
+#include "perftrace.h"
+#include "tilescheduler.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+
+namespace {
+
+struct Pipeline
+{
+    QList<ImageCommand *> commands;
+    QString format;     // 输出后缀，为空时沿用输入后缀
+    int threads = 0;
+};
+
+bool loadPipeline(const QString &path, Pipeline &pipeline, QString *errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorString = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (document.isNull()) {
+        *errorString = parseError.errorString();
+        return false;
+    }
+
+    QJsonArray descriptions;
+    if (document.isArray()) {
+        descriptions = document.array();
+    } else {
+        const QJsonObject object = document.object();
+        descriptions = object.value("commands").toArray();
+        pipeline.format = object.value("format").toString().toLower();
+        pipeline.threads = object.value("threads").toInt(0);
+    }
+    if (descriptions.isEmpty()) {
+        *errorString = QStringLiteral("命令链为空");
+        return false;
+    }
+    pipeline.commands = CommandFactory::createChain(descriptions, errorString);
+    return !pipeline.commands.isEmpty();
+}
+
+bool isReadable(const QString &suffix)
+{
+    static const QSet<QByteArray> formats = [] {
+        const QList<QByteArray> list = QImageReader::supportedImageFormats();
+        return QSet<QByteArray>(list.begin(), list.end());
+    }();
+    return MappedImageIO::supportsSuffix(suffix) || formats.contains(suffix.toLower().toLatin1());
+}
+
+bool saveImage(const QImage &image, const QString &filePath, QString *errorString)
+{
+    if (MappedImageIO::supportsSuffix(QFileInfo(filePath).suffix())) {
+        return MappedImageIO::write(image, filePath, errorString);
+    }
+    if (!image.save(filePath)) {
+        *errorString = QStringLiteral("无法写入");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int BatchProcessor::run(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (arguments.size() != 3) {
+        err << "用法：PSvidio --batch pipeline.json 输入目录 输出目录" << Qt::endl;
+        return 2;
+    }
+
+    Pipeline pipeline;
+    QString error;
+    if (!loadPipeline(arguments.at(0), pipeline, &error)) {
+        err << "流水线无效：" << error << Qt::endl;
+        return 2;
+    }
+
+    const QDir inputDir(arguments.at(1));
+    QDir outputDir(arguments.at(2));
+    if (!inputDir.exists() || !outputDir.mkpath(".")) {
+        err << "输入目录不存在或输出目录无法创建" << Qt::endl;
+        qDeleteAll(pipeline.commands);
+        return 2;
+    }
+    // 输出到输入目录会覆盖（或混入）输入文件
+    if (inputDir.canonicalPath() == outputDir.canonicalPath()) {
+        err << "输出目录不能与输入目录相同" << Qt::endl;
+        qDeleteAll(pipeline.commands);
+        return 2;
+    }
+
+    // 开始前确定全部输出路径：不同输入映射到同一输出（如指定 format 时的 a.png 与 a.jpg）时不执行，
+    // 否则两个线程会同时写同一个文件（按不区分大小写比较，兼顾 Windows/macOS 的文件系统）
+    QStringList files;
+    QStringList outputs;
+    QHash<QString, QString> outputOwners;
+    QStringList collisions;
+    for (const QFileInfo &info : inputDir.entryInfoList(QDir::Files, QDir::Name)) {
+        if (!isReadable(info.suffix())) continue;
+        const QString suffix = pipeline.format.isEmpty() ? info.suffix() : pipeline.format;
+        const QString outputName = info.completeBaseName() + '.' + suffix;
+        const QString key = outputName.toLower();
+        if (outputOwners.contains(key)) {
+            collisions.append(QStringLiteral("%1、%2 → %3").arg(outputOwners.value(key), info.fileName(), outputName));
+            continue;
+        }
+        outputOwners.insert(key, info.fileName());
+        files.append(info.absoluteFilePath());
+        outputs.append(outputDir.filePath(outputName));
+    }
+    if (!collisions.isEmpty()) {
+        err << "以下输入文件的输出文件名相同：" << Qt::endl;
+        for (const QString &collision : std::as_const(collisions)) {
+            err << "  " << collision << Qt::endl;
+        }
+        qDeleteAll(pipeline.commands);
+        return 2;
+    }
+
+    // 文件级并行：每个线程处理整张图片，图片内部单线程执行
+    const int previousThreads = TileScheduler::maxThreads();
+    TileScheduler::setMaxThreads(1);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(pipeline.threads > 0 ? pipeline.threads : QThread::idealThreadCount());
+
+    std::atomic<int> processed { 0 };
+    std::atomic<int> failed { 0 };
+    std::atomic<qint64> pixels { 0 };
+    QMutex errorMutex;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        pool.start([&, filePath = files.at(i), outputPath = outputs.at(i)]() {
+            PERF_TRACE("BatchProcessor::processFile");
+            const QFileInfo info(filePath);
+
+            QString fileError;
+            const QImage input = ImageLoader::readImage(filePath);
+            bool ok = !input.isNull();
+            if (!ok) {
+                fileError = QStringLiteral("无法读取");
+            } else {
+                const QImage result = ImageCommand::applyChain(pipeline.commands, input);
+                ok = saveImage(result, outputPath, &fileError);
+            }
+
+            if (ok) {
+                ++processed;
+                pixels += qint64(input.width()) * input.height();
+            } else {
+                ++failed;
+                QMutexLocker locker(&errorMutex);
+                err << info.fileName() << "：" << fileError << Qt::endl;
+            }
+        });
+    }
+    pool.waitForDone();
+
+    const double seconds = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+    out << QStringLiteral("处理 %1 张图片（失败 %2），%3 线程，耗时 %4 s：%5 images/s，%6 MP/s")
+               .arg(processed.load()).arg(failed.load()).arg(pool.maxThreadCount())
+               .arg(seconds, 0, 'f', 2)
+               .arg(processed.load() / seconds, 0, 'f', 1)
+               .arg(pixels.load() / 1e6 / seconds, 0, 'f', 1)
+        << Qt::endl;
+
+    TileScheduler::setMaxThreads(previousThreads);
+    qDeleteAll(pipeline.commands);
+    return failed.load() == 0 ? 0 : 1;
+}
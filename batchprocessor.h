@@ -0,0 +1,21 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QStringList>
+
+// 无界面批处理：PSvidio --batch pipeline.json 输入目录 输出目录
+// pipeline.json 为命令描述数组（格式见 CommandFactory），或对象
+//   { "commands": [...], "format": "png", "threads": 8 }
+// format 为输出格式后缀（默认沿用输入文件的后缀），threads 为并行处理的文件数（默认 CPU 逻辑核数）
+// 输出目录不能与输入目录相同；两个输入的输出文件名相同时（如 a.png 与 a.jpg 指定同一 format）不执行
+// 文件之间并行处理，每个线程同一时刻只持有一张图片，内存占用由线程数限定；
+// 单张图片内部不再分块并行（TileScheduler 限制为单线程），避免两级并行争抢核心
+// 命令链经 ImageCommand::applyChain 执行，相邻点运算融合为一遍
+class BatchProcessor
+{
+public:
+    // 参数为 --batch 之后的命令行参数；返回进程退出码
+    static int run(const QStringList &arguments);
+};
+
+#endif // BATCHPROCESSOR_H
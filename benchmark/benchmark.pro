@@ -0,0 +1,12 @@
+# 性能基准：对各图像命令和显示缩放路径计时，结果输出为 JSON，可与基线比较
+QT += core gui concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = psvidio-benchmark
+
+include(../core.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,295 @@
+// 命令性能基准
+// 对每个命令 × 图片尺寸 × 像素格式 × 线程数组合计时（预热一次后取多次运行的中位数），
+// 结果输出为 JSON；指定 --baseline 时与基线逐项比较，中位耗时变慢超过容差的记为回退，
+// 存在回退时进程以 1 退出，便于在持续集成中使用
+#include "grayscalecommand.h"
+#include "binarycommand.h"
+#include "meanfiltercommand.h"
+#include "gammacorrectioncommand.h"
+#include "edgedetectioncommand.h"
+#include "imagepyramid.h"
+#include "boxfilter.h"
+#include "tilescheduler.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+namespace {
+
+struct Format
+{
+    const char *name;
+    QImage::Format format;
+};
+
+const Format Formats[] = {
+    { "ARGB32", QImage::Format_ARGB32 },
+    { "RGB32", QImage::Format_RGB32 },
+    { "RGB888", QImage::Format_RGB888 },
+    { "Gray8", QImage::Format_Grayscale8 },
+};
+
+struct Case
+{
+    QString name;
+    std::function<QImage(const QImage &)> run;
+};
+
+// 显示路径的视口大小
+const QSize DisplaySize(1920, 1080);
+
+QList<Case> makeCases(QList<std::shared_ptr<ImageCommand>> &commands)
+{
+    auto add = [&](const QString &name, ImageCommand *command) {
+        commands.append(std::shared_ptr<ImageCommand>(command));
+        return Case { name, [command](const QImage &image) { return command->apply(image); } };
+    };
+
+    QList<Case> cases = {
+        add("grayscale", new GrayscaleCommand(QImage())),
+        add("binary", new BinaryCommand(QImage(), 128)),
+        add("gamma", new GammaCorrectionCommand(QImage(), 2.2)),
+        add("mean_r1", new MeanFilterCommand(QImage(), 1)),
+        add("mean_r7", new MeanFilterCommand(QImage(), 7)),
+        add("edge", new EdgeDetectionCommand(QImage(), 50)),
+    };
+
+    // 3×3 均值滤波的两种内存布局：交错（逐像素拆 B/G/R）与平面（含拆分、合并的转换开销）
+    cases.append({ "mean_r1_interleaved", [](const QImage &image) {
+                       return BoxFilter::filter(image, 1, BoxFilter::BorderMode::Clamp);
+                   } });
+    cases.append({ "mean_r1_planar", [](const QImage &image) {
+                       return BoxFilter::filterPlanar(image, 1, BoxFilter::BorderMode::Clamp);
+                   } });
+
+    // 融合点运算链：灰度化 → 伽马 → 二值化
+    const QList<ImageCommand *> chain = { commands.at(0).get(), commands.at(2).get(), commands.at(1).get() };
+    cases.append({ "chain_gray_gamma_binary",
+                   [chain](const QImage &image) { return ImageCommand::applyChain(chain, image); } });
+
+    // 显示缩放：构建金字塔，再从适合视口的层级平滑缩放到视口大小（与 ImageViewer 的取样方式相同）
+    cases.append({ "display_rescale", [](const QImage &image) {
+                       const ImagePyramid pyramid(image);
+                       const QSize target = image.size().scaled(DisplaySize, Qt::KeepAspectRatio);
+                       return pyramid.levelFor(target).scaled(target, Qt::IgnoreAspectRatio,
+                                                              Qt::SmoothTransformation);
+                   } });
+    return cases;
+}
+
+// 可复现的合成图片：平滑渐变叠加伪随机噪声，避免全同像素让某些路径过于乐观
+QImage syntheticImage(int megapixels, QImage::Format format)
+{
+    const qint64 pixels = qint64(megapixels) * 1000000;
+    const int width = int(std::sqrt(pixels * 4.0 / 3.0));
+    const int height = int(pixels / width);
+
+    QImage image(width, height, QImage::Format_ARGB32);
+    if (image.isNull()) return image;
+    TileScheduler::forEachBand(height, image.bytesPerLine(), 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            QRgb *row = reinterpret_cast<QRgb *>(image.scanLine(y));
+            quint32 state = 0x9E3779B9u ^ quint32(y * 2654435761u);
+            for (int x = 0; x < width; ++x) {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                const int noise = int(state & 31) - 16;
+                const int r = qBound(0, x * 255 / width + noise, 255);
+                const int g = qBound(0, y * 255 / height + noise, 255);
+                const int b = qBound(0, (x + y) * 255 / (width + height) + noise, 255);
+                row[x] = qRgba(r, g, b, 128 + int(state >> 25));
+            }
+        }
+    });
+    return format == QImage::Format_ARGB32 ? image : image.convertToFormat(format);
+}
+
+QList<int> parseIntList(const QString &text)
+{
+    QList<int> values;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int value = part.trimmed().toInt(&ok);
+        if (ok && value > 0) values.append(value);
+    }
+    return values;
+}
+
+double median(QList<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const qsizetype n = values.size();
+    return n % 2 ? values.at(n / 2) : (values.at(n / 2 - 1) + values.at(n / 2)) / 2.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("PSvidio 图像命令性能基准");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "图片尺寸列表（百万像素）", "MP,...", "1,4,16,50,100");
+    const QCommandLineOption formatsOption("formats", "像素格式列表", "names", "ARGB32,RGB32,RGB888,Gray8");
+    const QCommandLineOption casesOption("cases", "只运行名称包含其中之一的用例", "names");
+    const QCommandLineOption threadsOption("threads", "线程数列表（默认只测 CPU 逻辑核数）", "n,...");
+    const QCommandLineOption iterationsOption("iterations", "每项计时次数", "n", "5");
+    const QCommandLineOption outputOption("output", "结果 JSON 文件（默认输出到标准输出）", "file");
+    const QCommandLineOption baselineOption("baseline", "与之比较的基线 JSON 文件", "file");
+    const QCommandLineOption toleranceOption("tolerance", "判定回退的变慢百分比", "percent", "10");
+    parser.addOptions({ sizesOption, formatsOption, casesOption, threadsOption, iterationsOption,
+                        outputOption, baselineOption, toleranceOption });
+    parser.process(app);
+
+    const QList<int> sizes = parseIntList(parser.value(sizesOption));
+    QList<int> threadCounts = parseIntList(parser.value(threadsOption));
+    if (threadCounts.isEmpty()) threadCounts = { QThread::idealThreadCount() };
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const QStringList formatNames = parser.value(formatsOption).split(',', Qt::SkipEmptyParts);
+    const QStringList caseFilter = parser.value(casesOption).split(',', Qt::SkipEmptyParts);
+    const double tolerance = parser.value(toleranceOption).toDouble() / 100.0;
+
+    QList<std::shared_ptr<ImageCommand>> commands;
+    QList<Case> cases = makeCases(commands);
+    if (!caseFilter.isEmpty()) {
+        cases.erase(std::remove_if(cases.begin(), cases.end(), [&](const Case &c) {
+                        return std::none_of(caseFilter.begin(), caseFilter.end(),
+                                            [&](const QString &f) { return c.name.contains(f.trimmed()); });
+                    }), cases.end());
+    }
+
+    QJsonArray results;
+    for (int megapixels : sizes) {
+        for (const Format &format : Formats) {
+            if (!formatNames.contains(format.name, Qt::CaseInsensitive)) continue;
+
+            TileScheduler::setMaxThreads(QThread::idealThreadCount());
+            const QImage image = syntheticImage(megapixels, format.format);
+            if (image.isNull()) {
+                err << "无法分配 " << megapixels << " MP " << format.name << " 图片，跳过" << Qt::endl;
+                continue;
+            }
+            const double actualMP = image.width() * double(image.height()) / 1e6;
+
+            for (int threads : std::as_const(threadCounts)) {
+                TileScheduler::setMaxThreads(threads);
+                for (const Case &c : std::as_const(cases)) {
+                    c.run(image);  // 预热：查找表、线程池、页面分配
+
+                    QList<double> times;
+                    for (int i = 0; i < iterations; ++i) {
+                        QElapsedTimer timer;
+                        timer.start();
+                        const QImage result = c.run(image);
+                        times.append(timer.nsecsElapsed() / 1e6);
+                        Q_UNUSED(result);
+                    }
+
+                    const double medianMs = median(times);
+                    QJsonObject entry;
+                    entry["name"] = QString("%1/%2/%3MP/t%4").arg(c.name, format.name).arg(megapixels).arg(threads);
+                    entry["case"] = c.name;
+                    entry["format"] = format.name;
+                    entry["megapixels"] = megapixels;
+                    entry["width"] = image.width();
+                    entry["height"] = image.height();
+                    entry["threads"] = threads;
+                    entry["median_ms"] = medianMs;
+                    entry["min_ms"] = *std::min_element(times.begin(), times.end());
+                    entry["mp_per_s"] = actualMP / (medianMs / 1000.0);
+                    results.append(entry);
+
+                    err << QString("%1  %2 ms  %3 MP/s")
+                               .arg(entry["name"].toString(), -40)
+                               .arg(medianMs, 9, 'f', 2)
+                               .arg(entry["mp_per_s"].toDouble(), 8, 'f', 1)
+                        << Qt::endl;
+                }
+            }
+        }
+    }
+
+    QJsonObject report;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["qt_version"] = QString(qVersion());
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["ideal_threads"] = QThread::idealThreadCount();
+    report["iterations"] = iterations;
+    report["results"] = results;
+
+    // 与基线比较：按用例名称配对，只比较两边都有的项
+    int regressions = 0;
+    if (parser.isSet(baselineOption)) {
+        QFile file(parser.value(baselineOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "无法打开基线文件：" << file.fileName() << Qt::endl;
+            return 2;
+        }
+        QHash<QString, double> baseline;
+        const QJsonArray baselineResults = QJsonDocument::fromJson(file.readAll()).object().value("results").toArray();
+        for (const QJsonValue &value : baselineResults) {
+            baseline.insert(value["name"].toString(), value["median_ms"].toDouble());
+        }
+
+        QJsonArray comparison;
+        for (const QJsonValue &value : std::as_const(results)) {
+            const QString name = value["name"].toString();
+            if (!baseline.contains(name) || baseline.value(name) <= 0) continue;
+            const double ratio = value["median_ms"].toDouble() / baseline.value(name);
+            const bool regressed = ratio > 1.0 + tolerance;
+            regressions += regressed;
+
+            QJsonObject entry;
+            entry["name"] = name;
+            entry["baseline_ms"] = baseline.value(name);
+            entry["median_ms"] = value["median_ms"];
+            entry["ratio"] = ratio;
+            entry["regression"] = regressed;
+            comparison.append(entry);
+
+            if (regressed) {
+                err << QString("回退：%1  %2 ms → %3 ms（+%4%）")
+                           .arg(name).arg(baseline.value(name), 0, 'f', 2)
+                           .arg(value["median_ms"].toDouble(), 0, 'f', 2)
+                           .arg((ratio - 1.0) * 100.0, 0, 'f', 1)
+                    << Qt::endl;
+            }
+        }
+        report["baseline"] = parser.value(baselineOption);
+        report["tolerance_percent"] = tolerance * 100.0;
+        report["comparison"] = comparison;
+        report["regressions"] = regressions;
+    }
+
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "无法写入结果文件：" << file.fileName() << Qt::endl;
+            return 2;
+        }
+        file.write(json);
+    } else {
+        out << json;
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
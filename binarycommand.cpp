@@ -5,29 +5,23 @@ BinaryCommand::BinaryCommand(const QImage &originalImage, int threshold)
 {
 }
 
-QImage BinaryCommand::execute()
+QImage BinaryCommand::apply(const QImage &input) const
 {
-    QImage resultImage = m_originalImage.copy();
-
-    // 遍历每个像素
-    for (int y = 0; y < resultImage.height(); ++y) {
-        for (int x = 0; x < resultImage.width(); ++x) {
-            QColor pixelColor = resultImage.pixelColor(x, y);
-            // 计算灰度值
-            int grayValue = (pixelColor.red() + pixelColor.green() + pixelColor.blue()) / 3;
-            // 根据阈值二值化
-            if (grayValue > m_threshold) {
-                resultImage.setPixelColor(x, y, Qt::white);
-            } else {
-                resultImage.setPixelColor(x, y, Qt::black);
-            }
-        }
-    }
+    // 计算灰度值，并根据阈值二值化，输出单字节灰度图（Format_Grayscale8）
+    return PointOperation::threshold(m_threshold).apply(input);
+}
 
-    return resultImage;
+std::optional<PointOperation> BinaryCommand::pointOperation() const
+{
+    return PointOperation::threshold(m_threshold);
 }
 
 int BinaryCommand::threshold() const
 {
     return m_threshold;
 }
+
+QString BinaryCommand::cacheKey() const
+{
+    return QString("binary:%1").arg(m_threshold);
+}
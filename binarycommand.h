@@ -7,7 +7,9 @@ class BinaryCommand : public ImageCommand
 {
 public:
     BinaryCommand(const QImage &originalImage, int threshold);
-    QImage execute() override;
+    QImage apply(const QImage &input) const override;
+    std::optional<PointOperation> pointOperation() const override;
+    QString cacheKey() const override;
     int threshold() const;
 
 private:
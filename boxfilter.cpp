@@ -0,0 +1,424 @@
+#include "boxfilter.h"
+#include "pixelview.h"
+#include "planarimage.h"
+#include "tilescheduler.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define BOXFILTER_SSE2 1
+#  include <emmintrin.h>
+#endif
+
+namespace {
+
+// 以乘法和移位代替除法：只要 n * area < 2^40，(n * m) >> 40 与 n / area 完全一致
+// n ≤ 255 * area，因此要求窗口边长小于256，MaxRadius = 100 留有余量
+struct Divider
+{
+    explicit Divider(quint32 area)
+        : multiplier((quint64(1) << 40) / area + 1)
+    {
+    }
+    uint operator()(quint32 n) const { return uint((quint64(n) * multiplier) >> 40); }
+
+    quint64 multiplier;
+};
+
+// 32位乘法版本：2^24 / area 的乘数下只要 n * area < 2^24 即与 n / area 一致，
+// n ≤ 255 * area 时要求 area ≤ 256（半径不超过7），乘积不超过32位，可用32位向量乘法
+struct Divider32
+{
+    static constexpr int MaxRadius = 7;
+
+    explicit Divider32(quint32 area)
+        : multiplier((quint32(1) << 24) / area + 1)
+    {
+    }
+    uint operator()(quint32 n) const { return (n * multiplier) >> 24; }
+
+    quint32 multiplier;
+};
+
+// 带透明度的32位格式（Format_ARGB32）：透明度作为第4个通道一起求均值
+struct Argb32 : PixelView::Rgb32
+{
+};
+
+// 各格式的通道访问：RGB32 按 B/G/R 三个通道求和（输出透明度为255），ARGB32 另含透明度通道，
+// 灰度像素只有一个通道
+template<typename Format>
+struct Channels;
+
+template<>
+struct Channels<PixelView::Rgb32>
+{
+    static constexpr int Count = 3;
+    static quint32 get(QRgb pixel, int c) { return (pixel >> (8 * c)) & 0xff; }
+    template<typename Divide>
+    static QRgb average(const quint32 *sums, const Divide &divide)
+    {
+        return qRgb(divide(sums[2]), divide(sums[1]), divide(sums[0]));
+    }
+};
+
+template<>
+struct Channels<Argb32>
+{
+    static constexpr int Count = 4;
+    static quint32 get(QRgb pixel, int c) { return (pixel >> (8 * c)) & 0xff; }
+    template<typename Divide>
+    static QRgb average(const quint32 *sums, const Divide &divide)
+    {
+        return qRgba(divide(sums[2]), divide(sums[1]), divide(sums[0]), divide(sums[3]));
+    }
+};
+
+template<>
+struct Channels<PixelView::Gray8>
+{
+    static constexpr int Count = 1;
+    static quint32 get(uchar pixel, int) { return pixel; }
+    template<typename Divide>
+    static uchar average(const quint32 *sums, const Divide &divide) { return uchar(divide(sums[0])); }
+};
+
+// 计算一行的水平窗口和（多通道时按通道交错存放），padded 为左右各扩展 radius 的行
+template<typename Format, typename Pixel = typename Format::Pixel>
+void horizontalSums(const Pixel *row, const int *columnMap, Pixel *padded,
+                    int width, int radius, quint32 *sums)
+{
+    using C = Channels<Format>;
+    const int paddedWidth = width + 2 * radius;
+    for (int i = 0; i < paddedWidth; ++i) {
+        padded[i] = row[columnMap[i]];
+    }
+
+    quint32 sum[C::Count] = {};
+    for (int i = 0; i < 2 * radius + 1; ++i) {
+        for (int c = 0; c < C::Count; ++c) {
+            sum[c] += C::get(padded[i], c);
+        }
+    }
+
+    const int window = 2 * radius + 1;
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < C::Count; ++c) {
+            sums[C::Count * x + c] = sum[c];
+        }
+        if (x + 1 < width) {
+            const Pixel in = padded[x + window];
+            const Pixel out = padded[x];
+            for (int c = 0; c < C::Count; ++c) {
+                sum[c] += C::get(in, c) - C::get(out, c);
+            }
+        }
+    }
+}
+
+// 滑动窗口的工作缓冲区：每个线程分配一次，该线程领取的各行带复用（不再每个行带重新分配和清零）
+// padded 为扩展行（仅交错格式使用），ring 为环形缓冲区，columns 为列累加器，incoming 为移入行（仅平面格式使用）
+template<typename Pixel>
+struct BandBuffers
+{
+    std::vector<Pixel> padded;
+    std::vector<quint32> ring;
+    std::vector<quint32> columns;
+    std::vector<quint32> incoming;
+};
+
+template<typename Format>
+void filterImage(const QImage &source, QImage &resultImage, int radius, BoxFilter::BorderMode mode)
+{
+    using Pixel = typename Format::Pixel;
+    using C = Channels<Format>;
+    using BoxFilter::mapCoordinate;
+
+    const int width = source.width();
+    const int height = source.height();
+    const int window = 2 * radius + 1;
+    const int rowValues = C::Count * width;
+
+    const PixelView::ConstImageView<Format> src(source);
+    const PixelView::ImageView<Format> dst(resultImage);
+
+    // 预先计算扩展行的列映射表
+    std::vector<int> columnMap(width + 2 * radius);
+    for (int i = 0; i < int(columnMap.size()); ++i) {
+        columnMap[i] = mapCoordinate(i - radius, width, mode);
+    }
+    const Divider divide(quint32(window) * quint32(window));
+
+    // 每个行带独立维护滑动窗口，上下各需 radius 行邻域
+    // 环形缓冲区保存窗口内 window 行的水平和，列累加器保存窗口内的垂直和
+    auto filterBand = [&](int begin, int end, BandBuffers<Pixel> &buffers) {
+        Pixel *padded = buffers.padded.data();
+        quint32 *ring = buffers.ring.data();
+        std::vector<quint32> &columns = buffers.columns;
+        std::fill(columns.begin(), columns.end(), 0u);
+
+        auto ringRow = [&](int logicalRow) {
+            return ring + size_t((logicalRow - begin + radius) % window) * rowValues;
+        };
+
+        // 初始化：窗口覆盖第 begin-radius ~ begin+radius 行
+        for (int y = begin - radius; y <= begin + radius; ++y) {
+            quint32 *sums = ringRow(y);
+            horizontalSums<Format>(src.row(mapCoordinate(y, height, mode)), columnMap.data(),
+                           padded, width, radius, sums);
+            for (int i = 0; i < rowValues; ++i) {
+                columns[i] += sums[i];
+            }
+        }
+
+        for (int y = begin; y < end; ++y) {
+            Pixel *out = dst.row(y);
+            for (int x = 0; x < width; ++x) {
+                out[x] = C::average(columns.data() + C::Count * x, divide);
+            }
+
+            if (y + 1 < end) {
+                // 窗口下移一行：移出第 y-radius 行，移入第 y+radius+1 行（二者共用环形槽位）
+                quint32 *sums = ringRow(y - radius);
+                for (int i = 0; i < rowValues; ++i) {
+                    columns[i] -= sums[i];
+                }
+                horizontalSums<Format>(src.row(mapCoordinate(y + radius + 1, height, mode)),
+                               columnMap.data(), padded, width, radius, sums);
+                for (int i = 0; i < rowValues; ++i) {
+                    columns[i] += sums[i];
+                }
+            }
+        }
+    };
+
+    TileScheduler::forEachBandPerWorker(height, source.bytesPerLine(), radius, [&]() -> TileScheduler::BandFunction {
+        auto buffers = std::make_shared<BandBuffers<Pixel>>();
+        buffers->padded.resize(width + 2 * radius);
+        buffers->ring.resize(size_t(window) * rowValues);
+        buffers->columns.resize(size_t(rowValues));
+        return [&filterBand, buffers](int begin, int end) { filterBand(begin, end, *buffers); };
+    });
+}
+
+// 平面行的水平窗口和：p 左右各有至少 radius 个有效边框像素
+// 小半径逐个抽头累加（每个抽头是一次可向量化的整行加法），大半径用滑动窗口
+void planarHorizontalSums(const uchar *p, quint32 *sums, int width, int radius)
+{
+    if (radius <= 4) {
+        int x0 = 0;
+#ifdef BOXFILTER_SSE2
+        // 每次16个像素：抽头在16位通道中累加（至多9个抽头，不会溢出），再扩展为32位写出
+        const __m128i zero = _mm_setzero_si128();
+        for (; x0 + 16 <= width; x0 += 16) {
+            __m128i lo = zero;
+            __m128i hi = zero;
+            for (int k = -radius; k <= radius; ++k) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + x0 + k));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(bytes, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(bytes, zero));
+            }
+            __m128i *out = reinterpret_cast<__m128i *>(sums + x0);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+        }
+#endif
+        for (int x = x0; x < width; ++x) {
+            sums[x] = p[x - radius];
+        }
+        for (int k = -radius + 1; k <= radius; ++k) {
+            const uchar *tap = p + k;
+            for (int x = x0; x < width; ++x) {
+                sums[x] += tap[x];
+            }
+        }
+        return;
+    }
+
+    quint32 sum = 0;
+    for (int k = -radius; k <= radius; ++k) {
+        sum += p[k];
+    }
+    for (int x = 0; x < width; ++x) {
+        sums[x] = sum;
+        sum += quint32(p[x + radius + 1]) - p[x - radius];
+    }
+}
+
+// 融合的行更新：out = column / area，随后 column += next - outgoing，outgoing = next
+template<typename Divide>
+void planarRowUpdate(quint32 *column, const quint32 *next, quint32 *outgoing, uchar *out,
+                     int width, const Divide &divide)
+{
+    for (int x = 0; x < width; ++x) {
+        out[x] = uchar(divide(column[x]));
+        column[x] += next[x] - outgoing[x];
+        outgoing[x] = next[x];
+    }
+}
+
+#ifdef BOXFILTER_SSE2
+// 4个32位列和的均值：SSE2 没有32位乘法，奇偶通道分别用 32×32→64 位乘法
+inline __m128i divide4(__m128i sums, __m128i multiplier)
+{
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(sums, multiplier), 24);
+    const __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(sums, 32), multiplier), 24);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+template<>
+void planarRowUpdate(quint32 *column, const quint32 *next, quint32 *outgoing, uchar *out,
+                     int width, const Divider32 &divide)
+{
+    const __m128i multiplier = _mm_set1_epi32(int(divide.multiplier));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i averages[4];
+        for (int i = 0; i < 4; ++i) {
+            __m128i *c = reinterpret_cast<__m128i *>(column + x + 4 * i);
+            __m128i *o = reinterpret_cast<__m128i *>(outgoing + x + 4 * i);
+            const __m128i sums = _mm_loadu_si128(c);
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + x + 4 * i));
+            averages[i] = divide4(sums, multiplier);
+            _mm_storeu_si128(c, _mm_sub_epi32(_mm_add_epi32(sums, in), _mm_loadu_si128(o)));
+            _mm_storeu_si128(o, in);
+        }
+        // 均值不超过255，有符号饱和打包不会截断
+        const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(averages[0], averages[1]),
+                                                _mm_packs_epi32(averages[2], averages[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), packed);
+    }
+    for (; x < width; ++x) {
+        out[x] = uchar(divide(column[x]));
+        column[x] += next[x] - outgoing[x];
+        outgoing[x] = next[x];
+    }
+}
+#endif
+
+// 各平面的滑动窗口：边框已填充，窗口所需的 [begin-radius, end+radius) 行都可直接读取
+// 每行只做一遍融合循环：输出当前行的均值，同时把列和更新为下一行的窗口
+template<typename Divide>
+void filterPlanes(const PlanarImage &src, PlanarImage &resultImage, int radius, const Divide &divide)
+{
+    const int width = src.width();
+    const int height = src.height();
+    const int window = 2 * radius + 1;
+
+    auto filterBand = [&](int begin, int end, BandBuffers<uchar> &buffers) {
+        quint32 *ring = buffers.ring.data();
+        std::vector<quint32> &columns = buffers.columns;
+        std::vector<quint32> &incoming = buffers.incoming;
+
+        auto ringRow = [&](int logicalRow) {
+            return ring + size_t((logicalRow - begin + radius) % window) * width;
+        };
+
+        for (int plane = 0; plane < src.planeCount(); ++plane) {
+            std::fill(columns.begin(), columns.end(), 0u);
+            for (int y = begin - radius; y <= begin + radius; ++y) {
+                quint32 *sums = ringRow(y);
+                planarHorizontalSums(src.row(plane, y), sums, width, radius);
+                for (int x = 0; x < width; ++x) {
+                    columns[x] += sums[x];
+                }
+            }
+
+            quint32 *column = columns.data();
+            for (int y = begin; y < end; ++y) {
+                uchar *out = resultImage.row(plane, y);
+                if (y + 1 == end) {
+                    for (int x = 0; x < width; ++x) {
+                        out[x] = uchar(divide(column[x]));
+                    }
+                    break;
+                }
+
+                // 移出第 y-radius 行，移入第 y+radius+1 行（二者共用环形槽位）
+                quint32 *next = incoming.data();
+                planarHorizontalSums(src.row(plane, y + radius + 1), next, width, radius);
+                planarRowUpdate(column, next, ringRow(y - radius), out, width, divide);
+            }
+        }
+    };
+
+    TileScheduler::forEachBandPerWorker(height, qsizetype(width) * src.planeCount(), radius,
+                                        [&]() -> TileScheduler::BandFunction {
+        auto buffers = std::make_shared<BandBuffers<uchar>>();
+        buffers->ring.resize(size_t(window) * width);
+        buffers->columns.resize(width);
+        buffers->incoming.resize(width);
+        return [&filterBand, buffers](int begin, int end) { filterBand(begin, end, *buffers); };
+    });
+}
+
+} // namespace
+
+namespace BoxFilter {
+
+int mapCoordinate(int i, int size, BorderMode mode)
+{
+    if (mode == BorderMode::Clamp || size == 1) {
+        return qBound(0, i, size - 1);
+    }
+
+    // 镜像周期为 2(size-1)
+    const int period = 2 * (size - 1);
+    i %= period;
+    if (i < 0) i += period;
+    return i < size ? i : period - i;
+}
+
+QImage filter(const QImage &image, int radius, BorderMode mode, QImage target)
+{
+    // 灰度图按单通道处理，每像素的求和量只有32位图像的1/3
+    const QImage source = PixelView::isGray8(image) ? image : PixelView::toRgb32(image);
+    radius = qMin(radius, MaxRadius);
+    if (radius <= 0 || source.isNull()) {
+        return source;
+    }
+
+    QImage resultImage = target.size() == source.size() && target.format() == source.format()
+                             ? std::move(target) : QImage(source.size(), source.format());
+    if (PixelView::isGray8(source)) {
+        filterImage<PixelView::Gray8>(source, resultImage, radius, mode);
+    } else if (source.hasAlphaChannel()) {
+        filterImage<Argb32>(source, resultImage, radius, mode);
+    } else {
+        filterImage<PixelView::Rgb32>(source, resultImage, radius, mode);
+    }
+    return resultImage;
+}
+
+PlanarImage filterPlanar(PlanarImage &image, int radius, BorderMode mode)
+{
+    radius = qMin(radius, MaxRadius);
+    if (image.isNull() || radius <= 0 || image.halo() < radius) {
+        return image;
+    }
+    image.fillHalo(mode);
+
+    PlanarImage resultImage(image.width(), image.height(), image.planeCount());
+    const quint32 area = quint32(2 * radius + 1) * quint32(2 * radius + 1);
+    if (radius <= Divider32::MaxRadius) {
+        filterPlanes(image, resultImage, radius, Divider32(area));
+    } else {
+        filterPlanes(image, resultImage, radius, Divider(area));
+    }
+    return resultImage;
+}
+
+QImage filterPlanar(const QImage &image, int radius, BorderMode mode, QImage target)
+{
+    radius = qMin(radius, MaxRadius);
+    if (radius <= 0 || image.isNull()) {
+        return PixelView::isGray8(image) ? image : PixelView::toRgb32(image);
+    }
+    PlanarImage planar = PlanarImage::fromImage(image, radius);
+    return filterPlanar(planar, radius, mode).toImage(std::move(target));
+}
+
+} // namespace BoxFilter
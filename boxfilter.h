@@ -0,0 +1,37 @@
+#ifndef BOXFILTER_H
+#define BOXFILTER_H
+
+#include <QImage>
+
+class PlanarImage;
+
+// 任意半径的盒式（均值）滤波
+// 水平方向滑动窗口求和 + 垂直方向列累加器，每像素代价与半径无关
+namespace BoxFilter {
+
+// 边界处理方式：越界坐标映射回图像内部，内层循环中不再有边界判断
+enum class BorderMode {
+    Clamp,    // 复制边缘像素：-1 → 0
+    Reflect   // 以边缘像素为轴镜像（不重复边缘）：-1 → 1
+};
+
+// 支持的最大半径（201×201 窗口）
+constexpr int MaxRadius = 100;
+
+// 对32位或灰度图像做 (2r+1)×(2r+1) 均值滤波（灰度输入输出仍为灰度，带透明度的图像透明度一起滤波），
+// 结果为截断取整的平均值，半径限制在 [0, MaxRadius]
+// target 为调用者预先分配的输出缓冲（如 FramePool 的缓冲区，须为唯一引用），尺寸或格式不符时忽略并新分配
+QImage filter(const QImage &image, int radius, BorderMode mode, QImage target = QImage());
+
+// 平面布局的均值滤波：各通道平面独立处理，行内为连续字节，水平与垂直求和循环可向量化
+// 结果与 filter 逐位一致；会按 mode 填充 image 的边框，要求 image.halo() 不小于 radius
+PlanarImage filterPlanar(PlanarImage &image, int radius, BorderMode mode);
+// 便捷形式：拆分为平面、滤波、再合并为 QImage（含两次布局转换的开销），合并时写入 target（同 filter）
+QImage filterPlanar(const QImage &image, int radius, BorderMode mode, QImage target = QImage());
+
+// 把越界坐标按边界方式映射到 [0, size)
+int mapCoordinate(int i, int size, BorderMode mode);
+
+} // namespace BoxFilter
+
+#endif // BOXFILTER_H
@@ -0,0 +1,84 @@
+#include "commandfactory.h"
+#include "grayscalecommand.h"
+#include "binarycommand.h"
+#include "meanfiltercommand.h"
+#include "gammacorrectioncommand.h"
+#include "edgedetectioncommand.h"
+
+namespace {
+
+bool readInt(const QJsonObject &description, const QString &key, int defaultValue,
+             int minValue, int maxValue, int &value, QString *errorString)
+{
+    const QJsonValue json = description.value(key);
+    value = json.isUndefined() ? defaultValue : json.toInt(minValue - 1);
+    if (value < minValue || value > maxValue) {
+        if (errorString) {
+            *errorString = QStringLiteral("参数 %1 应为 %2~%3 的整数").arg(key).arg(minValue).arg(maxValue);
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+namespace CommandFactory {
+
+ImageCommand *create(const QJsonObject &description, QString *errorString)
+{
+    const QString type = description.value("type").toString().toLower();
+    int value;
+
+    if (type == "grayscale") {
+        return new GrayscaleCommand(QImage());
+    }
+    if (type == "binary") {
+        if (!readInt(description, "threshold", 128, 0, 255, value, errorString)) return nullptr;
+        return new BinaryCommand(QImage(), value);
+    }
+    if (type == "gamma") {
+        const double gamma = description.value("gamma").toDouble(1.0);
+        if (!(gamma > 0.0)) {
+            if (errorString) *errorString = QStringLiteral("参数 gamma 应大于0");
+            return nullptr;
+        }
+        return new GammaCorrectionCommand(QImage(), gamma);
+    }
+    if (type == "mean") {
+        if (!readInt(description, "radius", 1, 1, BoxFilter::MaxRadius, value, errorString)) return nullptr;
+        const QString border = description.value("border").toString("clamp").toLower();
+        if (border != "clamp" && border != "reflect") {
+            if (errorString) *errorString = QStringLiteral("参数 border 应为 clamp 或 reflect");
+            return nullptr;
+        }
+        return new MeanFilterCommand(QImage(), value,
+                                     border == "reflect" ? BoxFilter::BorderMode::Reflect
+                                                         : BoxFilter::BorderMode::Clamp);
+    }
+    if (type == "edge") {
+        if (!readInt(description, "threshold", 50, 0, 255, value, errorString)) return nullptr;
+        return new EdgeDetectionCommand(QImage(), value);
+    }
+
+    if (errorString) *errorString = QStringLiteral("未知的命令类型：%1").arg(type);
+    return nullptr;
+}
+
+QList<ImageCommand *> createChain(const QJsonArray &descriptions, QString *errorString)
+{
+    QList<ImageCommand *> commands;
+    for (qsizetype i = 0; i < descriptions.size(); ++i) {
+        QString error;
+        ImageCommand *command = create(descriptions.at(i).toObject(), &error);
+        if (!command) {
+            if (errorString) *errorString = QStringLiteral("第 %1 个命令：%2").arg(i + 1).arg(error);
+            qDeleteAll(commands);
+            return {};
+        }
+        commands.append(command);
+    }
+    return commands;
+}
+
+} // namespace CommandFactory
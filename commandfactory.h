@@ -0,0 +1,29 @@
+#ifndef COMMANDFACTORY_H
+#define COMMANDFACTORY_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+class ImageCommand;
+
+// 按名称和参数创建图像处理命令（批处理的流水线描述使用）
+// 支持的 type 及参数：
+//   grayscale
+//   binary     threshold（0~255，默认128）
+//   gamma      gamma（>0，默认1.0）
+//   mean       radius（1~BoxFilter::MaxRadius，默认1），border（"clamp" / "reflect"，默认 clamp）
+//   edge       threshold（0~255，默认50）
+// 创建的命令不持有原始图像，只通过 apply / applyChain 使用
+namespace CommandFactory {
+
+// 失败返回 nullptr 并写入 errorString；调用者负责释放返回的命令
+ImageCommand *create(const QJsonObject &description, QString *errorString = nullptr);
+
+// 依次创建整条命令链；任一命令无效时释放已创建的命令并返回空列表
+QList<ImageCommand *> createChain(const QJsonArray &descriptions, QString *errorString = nullptr);
+
+} // namespace CommandFactory
+
+#endif // COMMANDFACTORY_H
@@ -0,0 +1,51 @@
+# 图像处理核心：命令、像素内核、调度、历史与图片读写（不依赖界面，供 app 和 benchmark 共用）
+QT += core gui concurrent
+
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/grayscalecommand.cpp \
+    $$PWD/binarycommand.cpp \
+    $$PWD/meanfiltercommand.cpp \
+    $$PWD/gammacorrectioncommand.cpp \
+    $$PWD/edgedetectioncommand.cpp \
+    $$PWD/imagecommand.cpp \
+    $$PWD/pointkernels.cpp \
+    $$PWD/pointoperation.cpp \
+    $$PWD/boxfilter.cpp \
+    $$PWD/tilescheduler.cpp \
+    $$PWD/imagehistory.cpp \
+    $$PWD/resultcache.cpp \
+    $$PWD/imagepyramid.cpp \
+    $$PWD/imageloader.cpp \
+    $$PWD/mappedimageio.cpp \
+    $$PWD/commandfactory.cpp \
+    $$PWD/perftrace.cpp \
+    $$PWD/planarimage.cpp \
+    $$PWD/framepool.cpp
+
+HEADERS += \
+    $$PWD/grayscalecommand.h \
+    $$PWD/binarycommand.h \
+    $$PWD/meanfiltercommand.h \
+    $$PWD/gammacorrectioncommand.h \
+    $$PWD/edgedetectioncommand.h \
+    $$PWD/imagecommand.h \
+    $$PWD/pixelview.h \
+    $$PWD/pointkernels.h \
+    $$PWD/pointoperation.h \
+    $$PWD/boxfilter.h \
+    $$PWD/tilescheduler.h \
+    $$PWD/taskcontrol.h \
+    $$PWD/imagehistory.h \
+    $$PWD/resultcache.h \
+    $$PWD/imagepyramid.h \
+    $$PWD/imageloader.h \
+    $$PWD/mappedimageio.h \
+    $$PWD/commandfactory.h \
+    $$PWD/perftrace.h \
+    $$PWD/planarimage.h \
+    $$PWD/framepool.h
@@ -1,87 +1,200 @@
 #include "edgedetectioncommand.h"
-#include <cmath>
+#include "pixelview.h"
+#include "pointkernels.h"
+#include "tilescheduler.h"
+#include <cstring>
+#include <memory>
+#include <vector>
 
-EdgeDetectionCommand::EdgeDetectionCommand(const QImage &originalImage, int threshold)
-    : ImageCommand(originalImage, "边缘检测")
-    , m_threshold(threshold)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define EDGEDETECTION_SSE2 1
+#  include <emmintrin.h>
+#endif
+
+namespace {
+
+// 一行灰度的 Sobel 分量（可分离形式）
+// diff[x]   = g[x+1] - g[x-1]          （水平差分，供 x 方向梯度按 1:2:1 垂直加权）
+// smooth[x] = g[x-1] + 2g[x] + g[x+1]  （水平平滑，供 y 方向梯度上下相减）
+struct SobelRow
 {
-}
+    std::vector<qint16> diff;
+    std::vector<qint16> smooth;
+};
+
+// 三行滚动缓冲和灰度行：每个线程分配一次，该线程领取的各行带复用
+struct BandBuffers
+{
+    std::vector<uchar> gray;
+    SobelRow rows[3];
+};
 
-QImage EdgeDetectionCommand::execute()
+// 一行的灰度：32位像素即时计算，灰度图直接复制
+inline void loadGrayRow(const QRgb *row, uchar *gray, int width)
 {
-    return sobelEdgeDetection(m_originalImage, m_threshold);
+    PointKernels::grayRgb32ToGray8(row, gray, width);
 }
 
-int EdgeDetectionCommand::threshold() const
+inline void loadGrayRow(const uchar *row, uchar *gray, int width)
 {
-    return m_threshold;
+    std::memcpy(gray, row, size_t(width));
 }
 
-QImage EdgeDetectionCommand::toGrayscale(const QImage &image)
+// 计算第 y 行的灰度并得到 Sobel 分量，左右边界复制边缘像素
+template<typename Pixel>
+void computeSobelRow(const Pixel *row, int width, std::vector<uchar> &gray, SobelRow &out)
 {
-    QImage grayImage(image.width(), image.height(), QImage::Format_Grayscale8);
+    loadGrayRow(row, gray.data() + 1, width);
+    gray[0] = gray[1];
+    gray[width + 1] = gray[width];
 
-    for (int y = 0; y < image.height(); ++y) {
-        for (int x = 0; x < image.width(); ++x) {
-            QColor pixelColor = image.pixelColor(x, y);
-            int grayValue = (pixelColor.red() + pixelColor.green() + pixelColor.blue()) / 3;
-            grayImage.setPixel(x, y, grayValue);
-        }
+    const uchar *g = gray.data() + 1;
+    qint16 *diff = out.diff.data();
+    qint16 *smooth = out.smooth.data();
+    for (int x = 0; x < width; ++x) {
+        diff[x] = qint16(g[x + 1] - g[x - 1]);
+        smooth[x] = qint16(g[x - 1] + 2 * g[x] + g[x + 1]);
     }
-
-    return grayImage;
 }
 
-QImage EdgeDetectionCommand::sobelEdgeDetection(const QImage &image, int threshold)
+// 合成梯度并与阈值比较：gx² + gy² > limit 为边缘（255），否则为 0
+void combineRows(const SobelRow &above, const SobelRow &current, const SobelRow &below,
+                 int width, qint32 limit, uchar *out)
 {
-    // 转换为灰度图
-    QImage grayImage = toGrayscale(image);
-    QImage resultImage(grayImage.width(), grayImage.height(), QImage::Format_Grayscale8);
-
-    // Sobel算子
-    int sobelX[3][3] = {
-        {-1, 0, 1},
-        {-2, 0, 2},
-        {-1, 0, 1}
+    const qint16 *da = above.diff.data();
+    const qint16 *dc = current.diff.data();
+    const qint16 *db = below.diff.data();
+    const qint16 *sa = above.smooth.data();
+    const qint16 *sb = below.smooth.data();
+
+    int x = 0;
+#ifdef EDGEDETECTION_SSE2
+    const __m128i limitVec = _mm_set1_epi32(limit);
+    auto edgeMask8 = [&](int i) {
+        const __m128i dAbove = _mm_loadu_si128(reinterpret_cast<const __m128i *>(da + i));
+        const __m128i dCurrent = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dc + i));
+        const __m128i dBelow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(db + i));
+        const __m128i gx = _mm_add_epi16(_mm_add_epi16(dAbove, dBelow), _mm_slli_epi16(dCurrent, 1));
+        const __m128i gy = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(sb + i)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(sa + i)));
+        // (gx, gy) 交错后用 madd 一次得到 gx² + gy²（32位）
+        const __m128i lo = _mm_unpacklo_epi16(gx, gy);
+        const __m128i hi = _mm_unpackhi_epi16(gx, gy);
+        const __m128i maskLo = _mm_cmpgt_epi32(_mm_madd_epi16(lo, lo), limitVec);
+        const __m128i maskHi = _mm_cmpgt_epi32(_mm_madd_epi16(hi, hi), limitVec);
+        return _mm_packs_epi32(maskLo, maskHi);
     };
+    for (; x + 16 <= width; x += 16) {
+        const __m128i mask = _mm_packs_epi16(edgeMask8(x), edgeMask8(x + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), mask);
+    }
+#endif
+    for (; x < width; ++x) {
+        const qint32 gx = da[x] + 2 * dc[x] + db[x];
+        const qint32 gy = sb[x] - sa[x];
+        out[x] = (gx * gx + gy * gy > limit) ? 255 : 0;
+    }
+}
+
+template<typename Format>
+void sobelRows(const QImage &source, QImage &resultImage, int threshold)
+{
+    const int width = source.width();
+    const int height = source.height();
+    const PixelView::ConstImageView<Format> src(source);
+    const PixelView::Gray8View result(resultImage);
+
+    // qRound(sqrt(m)) > t  等价于  m > t² + t（m 为整数），无需开方
+    // 阈值为负时所有像素都是边缘
+    const qint32 limit = threshold < 0 ? -1 : threshold * threshold + threshold;
+
+    // 每个行带从自己的第一行重新开始滚动，上下各需1行邻域
+    auto filterBand = [&](int begin, int end, BandBuffers &buffers) {
+        // 灰度在读取时即时计算，每行只计算一次；上下边界复制边缘行
+        std::vector<uchar> &gray = buffers.gray;
+        SobelRow *above = &buffers.rows[0];
+        SobelRow *current = &buffers.rows[1];
+        SobelRow *below = &buffers.rows[2];
+
+        computeSobelRow(src.row(qMax(begin - 1, 0)), width, gray, *above);
+        computeSobelRow(src.row(begin), width, gray, *current);
 
-    int sobelY[3][3] = {
-        {-1, -2, -1},
-        {0, 0, 0},
-        {1, 2, 1}
+        for (int y = begin; y < end; ++y) {
+            computeSobelRow(src.row(qMin(y + 1, height - 1)), width, gray, *below);
+            combineRows(*above, *current, *below, width, limit, result.row(y));
+
+            // 滚动：当前行变为上一行，下一行变为当前行
+            SobelRow *recycled = above;
+            above = current;
+            current = below;
+            below = recycled;
+        }
     };
 
-    int width = grayImage.width();
-    int height = grayImage.height();
-
-    // 应用Sobel算子
-    for (int y = 1; y < height - 1; ++y) {
-        for (int x = 1; x < width - 1; ++x) {
-            int gradientX = 0;
-            int gradientY = 0;
-
-            // 计算x和y方向的梯度
-            for (int ky = -1; ky <= 1; ++ky) {
-                for (int kx = -1; kx <= 1; ++kx) {
-                    int nx = x + kx;
-                    int ny = y + ky;
-                    int pixelValue = grayImage.pixel(nx, ny) & 0xFF;
-                    
-                    gradientX += pixelValue * sobelX[ky + 1][kx + 1];
-                    gradientY += pixelValue * sobelY[ky + 1][kx + 1];
-                }
-            }
-
-            // 计算梯度幅值
-            int gradientMagnitude = qRound(sqrt(gradientX * gradientX + gradientY * gradientY));
-            
-            // 根据阈值进行二值化处理
-            int edgeValue = (gradientMagnitude > threshold) ? 255 : 0;
-
-            // 设置边缘检测结果
-            resultImage.setPixel(x, y, edgeValue);
+    TileScheduler::forEachBandPerWorker(height, source.bytesPerLine(), 1, [&]() -> TileScheduler::BandFunction {
+        auto buffers = std::make_shared<BandBuffers>();
+        buffers->gray.resize(width + 2);
+        for (SobelRow &row : buffers->rows) {
+            row.diff.resize(width);
+            row.smooth.resize(width);
         }
+        return [&filterBand, buffers](int begin, int end) { filterBand(begin, end, *buffers); };
+    });
+}
+
+} // namespace
+
+EdgeDetectionCommand::EdgeDetectionCommand(const QImage &originalImage, int threshold)
+    : ImageCommand(originalImage, "边缘检测")
+    , m_threshold(threshold)
+{
+}
+
+QImage EdgeDetectionCommand::apply(const QImage &input) const
+{
+    return sobelEdgeDetection(input, m_threshold, QImage());
+}
+
+QImage EdgeDetectionCommand::applyInto(const QImage &input, QImage target) const
+{
+    return sobelEdgeDetection(input, m_threshold, std::move(target));
+}
+
+QImage::Format EdgeDetectionCommand::resultFormat(const QImage &input) const
+{
+    Q_UNUSED(input);
+    return QImage::Format_Grayscale8;
+}
+
+int EdgeDetectionCommand::threshold() const
+{
+    return m_threshold;
+}
+
+QImage EdgeDetectionCommand::sobelEdgeDetection(const QImage &image, int threshold, QImage target) const
+{
+    // 灰度输入省去逐行的灰度计算
+    const QImage source = PixelView::isGray8(image) ? image : PixelView::toRgb32(image);
+    QImage resultImage = target.size() == source.size() && target.format() == QImage::Format_Grayscale8
+                             ? std::move(target) : QImage(source.size(), QImage::Format_Grayscale8);
+    if (source.isNull()) {
+        return resultImage;
     }
 
+    if (PixelView::isGray8(source)) {
+        sobelRows<PixelView::Gray8>(source, resultImage, threshold);
+    } else {
+        sobelRows<PixelView::Rgb32>(source, resultImage, threshold);
+    }
     return resultImage;
 }
+
+QString EdgeDetectionCommand::cacheKey() const
+{
+    return QString("edge:%1").arg(m_threshold);
+}
+
+bool EdgeDetectionCommand::readsGrayOnly() const
+{
+    return true;
+}
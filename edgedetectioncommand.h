@@ -7,18 +7,20 @@ class EdgeDetectionCommand : public ImageCommand
 {
 public:
     EdgeDetectionCommand(const QImage &originalImage, int threshold = 50);
-    QImage execute() override;
+    QImage apply(const QImage &input) const override;
+    QImage applyInto(const QImage &input, QImage target) const override;
+    QImage::Format resultFormat(const QImage &input) const override;  // 总为 Grayscale8
+    QString cacheKey() const override;
+    bool readsGrayOnly() const override;  // 先计算灰度再求梯度
     
     // 获取当前阈值
     int threshold() const;
 
 private:
-    // Sobel边缘检测算法
-    QImage sobelEdgeDetection(const QImage &image, int threshold);
-    // 转换为灰度图
-    QImage toGrayscale(const QImage &image);
+    // Sobel边缘检测算法（灰度化与梯度计算融合为单遍）
+    QImage sobelEdgeDetection(const QImage &image, int threshold, QImage target) const;
     
     int m_threshold; // 边缘检测阈值
 };
 
-#endif // EDGEDETECTIONCOMMAND_H
\ No newline at end of file
+#endif // EDGEDETECTIONCOMMAND_H
@@ -1,12 +1,18 @@
 #include "fileviewsubwindow.h"
 #include <QPixmap>
-#include <QScrollArea>
 #include <QVBoxLayout>
 #include <QFileInfo>
 #include <QSizePolicy>
 #include <QDebug>
 #include <QResizeEvent>
 #include <QStyle>
+#include <QtConcurrent>
+#include <limits>
+#include "resultcache.h"
+#include "imageloader.h"
+#include "mappedimageio.h"
+#include "perftrace.h"
+#include "pixelview.h"
 
 
 // Qt6.9.2 构造函数
@@ -33,7 +39,8 @@ FileViewSubWindow::FileViewSubWindow(const QString &filePath, QWidget *parent)
 
     // 媒体类型判断
     const QString suffix = QFileInfo(filePath).suffix().toLower();
-    if (suffix == "jpg" || suffix == "jpeg" || suffix == "png" || suffix == "bmp") {
+    if (suffix == "jpg" || suffix == "jpeg" || suffix == "png" || suffix == "bmp"
+        || MappedImageIO::supportsSuffix(suffix)) {
         loadImage(filePath);
     } else if (suffix == "mp4" || suffix == "avi" || suffix == "mov") {
         loadVideo(filePath);
@@ -42,89 +49,459 @@ FileViewSubWindow::FileViewSubWindow(const QString &filePath, QWidget *parent)
     }
 }
 
-// 核心：加载图片（保持原始比例，初始适配窗口）
+// 析构：取消并等待后台任务，释放命令
+FileViewSubWindow::~FileViewSubWindow()
+{
+    for (const CommandJob &job : std::as_const(m_jobs)) {
+        job.control->cancel();
+        job.watcher->waitForFinished();
+        if (job.onCancelled) job.onCancelled();
+    }
+    if (m_videoProcessor) m_videoProcessor->waitForIdle();
+    // 导出未完成时取消（发出 finished 并删除未写完的文件）
+    VideoExporter *exporter = m_videoExporter;
+    m_videoExporter = nullptr;
+    delete exporter;
+    qDeleteAll(m_commandHistory);
+}
+
+// 核心：加载图片（后台解码，先显示缩小解码的预览，完整图片就绪后替换）
 void FileViewSubWindow::loadImage(const QString &filePath)
 {
-    // 1. 加载原始图片（保存到成员变量）
-    m_originalImage = QImage(filePath);
-    if (m_originalImage.isNull()) {
+    PERF_TRACE("FileViewSubWindow::loadImage");
+    m_operationTimer.start();
+
+    // 1. 图片显示控件：只绘制视口内可见的块，自带滚动条和拖动平移（原生适配高DPI）
+    m_viewer = new ImageViewer(this);
+    m_viewer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_contentWidget->layout()->addWidget(m_viewer);
+
+    // 滚轮/滑块缩放按帧合并：一帧内的多次请求只应用最后的比例
+    m_zoomTimer = new QTimer(this);
+    m_zoomTimer->setInterval(16);
+    m_zoomTimer->setSingleShot(true);
+    connect(m_zoomTimer, &QTimer::timeout, this, [this]() {
+        m_viewer->setScale(m_scalePercent / 100.0, true);
+    });
+
+    // 后台处理进度条（处理时显示在图片下方）
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setRange(0, 100);
+    m_progressBar->setMaximumHeight(16);
+    m_progressBar->setVisible(false);
+    m_contentWidget->layout()->addWidget(m_progressBar);
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(100);
+    connect(m_progressTimer, &QTimer::timeout, this, &FileViewSubWindow::updateProgress);
+
+    // 2. 加载期间进度条显示为忙碌状态，窗口立即可见
+    m_progressBar->setRange(0, 0);
+    m_progressBar->setVisible(true);
+
+    // 3. 在解码线程池中后台解码：缩小解码的预览优先调度，完整解码随后进行，预览先到时作为占位显示
+    QFutureWatcher<ImageLoader::Preview> *previewWatcher = new QFutureWatcher<ImageLoader::Preview>(this);
+    connect(previewWatcher, &QFutureWatcher<ImageLoader::Preview>::finished, this, [this, previewWatcher]() {
+        const ImageLoader::Preview preview = previewWatcher->result();
+        previewWatcher->deleteLater();
+        if (isImageReady() || !preview.imageSize.isValid()) return;
+
+        initScale(preview.imageSize);
+        m_viewer->setPlaceholder(preview.image, preview.imageSize);
+        m_viewer->setScale(m_scalePercent / 100.0);
+        notifyPreviewReady();
+    });
+    previewWatcher->setFuture(QtConcurrent::task([filePath]() {
+        PERF_TRACE("ImageLoader::readPreview");
+        return ImageLoader::readPreview(filePath, QSize(PreviewSide, PreviewSide));
+    }).onThreadPool(*ImageLoader::decodePool()).withPriority(1).spawn());
+
+    QFutureWatcher<QImage> *imageWatcher = new QFutureWatcher<QImage>(this);
+    connect(imageWatcher, &QFutureWatcher<QImage>::finished, this, [this, imageWatcher, filePath]() {
+        const QImage image = imageWatcher->result();
+        imageWatcher->deleteLater();
+        finishLoading(filePath, image);
+    });
+    imageWatcher->setFuture(QtConcurrent::run(ImageLoader::decodePool(), [filePath]() {
+        PerfTrace::Scope trace("ImageLoader::readImage");
+        const QImage image = ImageLoader::readImage(filePath);
+        trace.setMegapixels(PerfTrace::megapixels(image.size()));
+        return image;
+    }));
+}
+
+// 完整图片解码完成：初始化当前图片和命令历史，启用命令
+void FileViewSubWindow::finishLoading(const QString &filePath, const QImage &image)
+{
+    m_progressBar->setVisible(false);
+    m_progressBar->setRange(0, 100);
+
+    if (image.isNull()) {
+        m_viewer->setVisible(false);
         m_imageLabel = new QLabel(tr("图片加载失败：%1").arg(filePath), this);
         m_imageLabel->setAlignment(Qt::AlignCenter);
         m_contentWidget->layout()->addWidget(m_imageLabel);
+        notifyPreviewReady();
+        emit loadFinished(false);
         return;
     }
 
-    // 2. 初始化图片显示标签
-    m_imageLabel = new QLabel(this);
-    m_imageLabel->setAlignment(Qt::AlignCenter);
-    m_imageLabel->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-
-    // 3. 滚动区域配置（原生适配高DPI）
-    QScrollArea *scrollArea = new QScrollArea(this);
-    scrollArea->setWidget(m_imageLabel);
-    scrollArea->setWidgetResizable(true);
-    scrollArea->setFrameShape(QFrame::NoFrame);
-    scrollArea->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    m_contentWidget->layout()->addWidget(scrollArea);
-
-    // 4. 初始化当前图片和命令历史
-    m_currentImage = m_originalImage;
+    PERF_TRACE("FileViewSubWindow::finishLoading", PerfTrace::megapixels(image.size()));
+
+    // 初始化当前图片和命令历史（原图作为第0个快照保存，与当前图片共享缓冲区）
+    m_currentImage = image;
     m_commandHistory.clear();
     m_historyIndex = -1;
+    m_history = std::make_unique<ImageHistory>(image);
+
+    if (!m_scaleInitialized) {
+        initScale(image.size());
+    }
+    updateImageDisplay();
+
+    notifyPreviewReady();
+    emit operationTimed(tr("打开"), m_operationTimer.nsecsElapsed(), PerfTrace::megapixels(image.size()));
+    emit imageReady();
+    emit loadFinished(true);
+}
+
+// 首次有可显示内容（预览、完整图片或失败提示）时通知一次
+void FileViewSubWindow::notifyPreviewReady()
+{
+    if (m_previewNotified) return;
+    m_previewNotified = true;
+    emit previewReady();
+}
+
+// 是否已有可显示的内容（只有图片需要等待解码，视频等窗口构造后即可显示）
+bool FileViewSubWindow::hasPreview() const
+{
+    return m_previewNotified || !m_viewer;
+}
 
-    // 5. 初始缩放：适配窗口（图片最大边不超过窗口，保持比例）
+// 初始缩放：适配窗口（图片最大边不超过窗口，保持比例）
+void FileViewSubWindow::initScale(const QSize &originalSize)
+{
     QSize windowSize = this->size() * 20;  // 留10%边距
     qDebug() << "this->size()" << this->size();
     qDebug() << "初始比例：" << windowSize;
-    QSize imageSize = m_currentImage.size();
+    QSize imageSize = originalSize;
     imageSize.scale(windowSize, Qt::KeepAspectRatio);  // 按窗口适配比例
-    m_scalePercent = qRound((imageSize.width() * 100.0) / m_currentImage.width());
-    updateImageDisplay();
+    m_scalePercent = qRound((imageSize.width() * 100.0) / originalSize.width());
+    m_scaleInitialized = true;
+    emit scaleChanged(m_scalePercent);
+}
+
+// 完整图片是否已解码（之前只显示预览，命令不可用）
+bool FileViewSubWindow::isImageReady() const
+{
+    return m_history != nullptr;
+}
+
+// 命令可用：图片已完整解码，或为视频窗口
+bool FileViewSubWindow::acceptsCommands() const
+{
+    return isImageReady() || (m_videoProcessor != nullptr && !m_videoExporter);
 }
 
 // 核心：更新图片显示（保持比例，按当前缩放比例渲染）
 void FileViewSubWindow::updateImageDisplay()
 {
-    if (m_currentImage.isNull() || !m_imageLabel) return;
+    if (m_currentImage.isNull() || !m_viewer) return;
+    PERF_TRACE("FileViewSubWindow::updateImageDisplay", PerfTrace::megapixels(m_currentImage.size()));
 
-    // 计算缩放后的尺寸（保持原始比例）
-    qreal scale = m_scalePercent / 100.0;
-    QSize scaledSize = m_currentImage.size() * scale;
+    // 金字塔过期时在后台重建，就绪后查看控件改从其层级取样
+    ensurePyramid();
 
-    // 高质量缩放（Qt6最优算法，无模糊）
-    QPixmap scaledPixmap = QPixmap::fromImage(m_currentImage.scaled(
-        scaledSize,
-        Qt::KeepAspectRatio,
-        Qt::SmoothTransformation
-        ));
+    // 查看控件只按当前缩放比例渲染可见区域（居中，不拉伸）
+    m_viewer->setImage(m_currentImage, m_pyramid);
+    m_viewer->setScale(m_scalePercent / 100.0);
+}
 
-    // 显示图片（居中，不拉伸）
-    m_imageLabel->setPixmap(scaledPixmap);
-    m_imageLabel->adjustSize();  // 适配图片尺寸
+// 缩放显示的源图：金字塔就绪时取不小于目标尺寸的最小层级，否则用原尺寸图片并在后台构建
+QImage FileViewSubWindow::displaySource(const QSize &targetSize)
+{
+    if (m_pyramid.sourceKey() != m_currentImage.cacheKey()) {
+        ensurePyramid();
+        return m_currentImage;
+    }
+    return m_pyramid.levelFor(targetSize);
 }
 
-// 应用图像处理命令
+// 在后台构建当前图片的金字塔（同一图片只构建一次）
+void FileViewSubWindow::ensurePyramid()
+{
+    const qint64 key = m_currentImage.cacheKey();
+    if (m_pyramid.sourceKey() != key) {
+        m_pyramid = ImagePyramid();  // 释放过期层级
+    }
+    if (m_currentImage.isNull() || m_pyramid.sourceKey() == key || m_pyramidPendingKey == key) return;
+    m_pyramidPendingKey = key;
+
+    QFutureWatcher<ImagePyramid> *watcher = new QFutureWatcher<ImagePyramid>(this);
+    connect(watcher, &QFutureWatcher<ImagePyramid>::finished, this, [this, watcher]() {
+        const ImagePyramid pyramid = watcher->result();
+        watcher->deleteLater();
+        if (m_pyramidPendingKey == pyramid.sourceKey()) {
+            m_pyramidPendingKey = 0;
+        }
+        // 构建期间图片可能已变化，过期的金字塔直接丢弃
+        if (pyramid.sourceKey() == m_currentImage.cacheKey()) {
+            m_pyramid = pyramid;
+            if (m_viewer) m_viewer->setPyramid(pyramid);
+        }
+    });
+
+    const QImage image = m_currentImage;
+    watcher->setFuture(QtConcurrent::run([image]() {
+        PERF_TRACE("ImagePyramid", PerfTrace::megapixels(image.size()));
+        return ImagePyramid(image);
+    }));
+}
+
+// 预览代理图：当前图片缩小到屏幕显示尺寸（不放大，最长边不超过2048像素）
+QImage FileViewSubWindow::previewSource()
+{
+    if (m_currentImage.isNull()) return QImage();
+
+    if (m_proxyKey == m_currentImage.cacheKey() && m_proxyScalePercent == m_scalePercent) {
+        return m_proxyImage;
+    }
+
+    const int maxSide = 2048;
+    QSize proxySize = m_currentImage.size() * (qMin(m_scalePercent, 100) / 100.0);
+    if (proxySize.width() > maxSide || proxySize.height() > maxSide) {
+        proxySize.scale(maxSide, maxSide, Qt::KeepAspectRatio);
+    }
+
+    proxySize = proxySize.expandedTo(QSize(1, 1));
+    m_proxyImage = displaySource(proxySize).scaled(proxySize, Qt::KeepAspectRatio,
+                                                   Qt::SmoothTransformation);
+    m_proxyKey = m_currentImage.cacheKey();
+    m_proxyScalePercent = m_scalePercent;
+    return m_proxyImage;
+}
+
+// 在代理图上同步执行命令并直接显示（全分辨率结果在滑块释放后计算）
+void FileViewSubWindow::previewCommand(const ImageCommand &command)
+{
+    if (!m_viewer || !isImageReady()) return;
+
+    const QImage preview = command.apply(previewSource());
+    if (preview.isNull()) return;
+
+    // 代理图已接近显示尺寸，由查看控件拉伸到当前图片的显示区域
+    m_viewer->setPreview(preview);
+}
+
+// 应用图像处理命令（后台执行，完成后再加入历史记录）
 void FileViewSubWindow::applyImageCommand(ImageCommand *command)
 {
-    if (!command || m_currentImage.isNull()) return;
+    if (!command) return;
+    if (m_videoProcessor) {
+        // 导出使用着历史中的命令，期间不修改历史
+        if (m_videoExporter) {
+            delete command;
+            return;
+        }
+        // 视频：命令追加到实时处理链（丢弃可重做的命令），后续帧按新链处理
+        while (m_historyIndex < m_commandHistory.size() - 1) {
+            m_videoProcessor->waitForIdle();
+            delete m_commandHistory.takeLast();
+        }
+        m_commandHistory.append(command);
+        m_historyIndex++;
+        applyVideoChain();
+        emit commandApplied(command);
+        return;
+    }
+    if (!isImageReady()) {
+        // 图片尚未完整解码，命令不可用
+        delete command;
+        return;
+    }
+
+    // 输入即当前快照时，参数相同的命令（如滑块拖回原值）直接取用缓存结果
+    const QImage input = command->undo();
+    QString cacheKey;
+    if (input.cacheKey() == m_currentImage.cacheKey()) {
+        cacheKey = ResultCache::key(m_history->snapshotId(m_historyIndex + 1), *command);
+        QImage cached;
+        if (ResultCache::lookup(cacheKey, &cached)) {
+            QElapsedTimer timer;
+            timer.start();
+            cancelProcessing();
+            commitCommand(command, cached);
+            emit operationTimed(command->name(), timer.nsecsElapsed(), PerfTrace::megapixels(cached.size()));
+            return;
+        }
+    }
+
+    runCommandAsync(command, commandInput(input), [this, command, cacheKey](const QImage &result) {
+        if (!cacheKey.isEmpty()) {
+            ResultCache::insert(cacheKey, result);
+        }
+        commitCommand(command, result);
+    }, [command]() {
+        // 被更新的命令取代，结果丢弃
+        delete command;
+    });
+}
+
+// 命令结果加入历史记录并显示
+void FileViewSubWindow::commitCommand(ImageCommand *command, const QImage &result)
+{
+    PERF_TRACE("FileViewSubWindow::commitCommand", PerfTrace::megapixels(result.size()));
 
     // 清除当前历史记录之后的命令
     while (m_historyIndex < m_commandHistory.size() - 1) {
-        delete m_commandHistory.takeLast();
+        ImageCommand *dropped = m_commandHistory.takeLast();
+        waitForJobsUsing(dropped);
+        delete dropped;
     }
 
-    // 添加新命令到历史记录
+    // 添加新命令到历史记录：结果与当前图片共享缓冲区，离开这一步时才切块保存（与上一步共享未修改的块）
+    m_history->truncate(m_historyIndex + 2);
     m_commandHistory.append(command);
     m_historyIndex++;
+    m_history->append(result);
+    command->releaseOriginalImage();
 
-    // 执行命令并更新当前图片
-    m_currentImage = command->execute();
+    // 更新当前图片
+    m_currentImage = result;
     updateImageDisplay();
-    
+
     // 发出命令应用信号
     emit commandApplied(command);
 }
 
+// 命令的全分辨率输入：当前图片是映射读取的非规范格式（如 PPM 的 RGB888）时，首次执行命令前转换一次，
+// 转换结果替换历史中的当前快照，之后的命令、撤销和重新计算都直接使用它，不再逐次转换；
+// 显示仍使用原图（内容相同，金字塔和代理图无需重建）
+QImage FileViewSubWindow::commandInput(const QImage &input)
+{
+    if (input.cacheKey() != m_currentImage.cacheKey()) return input;
+
+    const QImage stored = m_history->image(m_historyIndex + 1);
+    const QImage source = stored.isNull() ? input : stored;
+    if (source.format() == PixelView::canonicalFormat(source)) return source;
+
+    PERF_TRACE("FileViewSubWindow::commandInput", PerfTrace::megapixels(source.size()));
+    const QImage canonical = PixelView::toCanonical(source);
+    m_history->replaceCurrent(canonical);
+    return canonical;
+}
+
+// 取出第 index 个历史快照；已被淘汰时查结果缓存，未命中返回空图像（由调用者在后台重新计算）
+QImage FileViewSubWindow::historyImage(int index)
+{
+    if (index <= 0 || m_history->isStored(index)) {
+        return m_history->image(index);
+    }
+
+    const QString key = ResultCache::key(m_history->snapshotId(index - 1), *m_commandHistory[index - 1]);
+    QImage image;
+    ResultCache::lookup(key, &image);
+    return image;
+}
+
+// 在后台线程执行命令
+void FileViewSubWindow::runCommandAsync(ImageCommand *command, const QImage &input,
+                                        std::function<void(const QImage &)> onFinished,
+                                        std::function<void()> onCancelled)
+{
+    runChainAsync({ command }, input, command->name(), std::move(onFinished), std::move(onCancelled));
+}
+
+// 在后台线程依次执行命令链：相邻的点运算（灰度、二值化、伽马）经 ImageCommand::applyChain 融合为单遍查找表；
+// 撤销时从保留快照重新计算跨越多步的命令，连续的点运算步骤只遍历图像一次
+void FileViewSubWindow::runChainAsync(const QList<ImageCommand *> &chain, const QImage &input,
+                                      const QString &name,
+                                      std::function<void(const QImage &)> onFinished,
+                                      std::function<void()> onCancelled)
+{
+    ImageCommand *command = chain.last();
+
+    // 新命令或新的滑块值到来时，取消仍在执行的旧任务
+    cancelProcessing();
+
+    std::shared_ptr<TaskControl> control = std::make_shared<TaskControl>();
+    m_activeControl = control;
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    m_jobs.append({ watcher, command, control, onCancelled });
+
+    // 从提交到结果显示的耗时（含排队和加入历史），显示在状态栏
+    QElapsedTimer timer;
+    timer.start();
+
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [=]() {
+        for (int i = 0; i < m_jobs.size(); ++i) {
+            if (m_jobs[i].watcher == watcher) {
+                m_jobs.removeAt(i);
+                break;
+            }
+        }
+        watcher->deleteLater();
+
+        if (control->isCancelled()) {
+            if (onCancelled) onCancelled();
+            return;
+        }
+
+        m_activeControl.reset();
+        m_progressTimer->stop();
+        m_progressBar->setVisible(false);
+        const QImage result = watcher->result();
+        onFinished(result);
+        emit operationTimed(name, timer.nsecsElapsed(), PerfTrace::megapixels(result.size()));
+    });
+
+    // 取消检查在 TileScheduler 的行带粒度上进行
+    watcher->setFuture(QtConcurrent::run([chain, input, control]() {
+        TaskControl::Scope scope(control.get());
+        return ImageCommand::applyChain(chain, input);
+    }));
+
+    m_progressBar->setValue(0);
+    m_progressBar->setVisible(true);
+    m_progressTimer->start();
+}
+
+// 刷新进度条
+void FileViewSubWindow::updateProgress()
+{
+    if (!m_activeControl) return;
+    m_progressBar->setValue(qRound(m_activeControl->progress() * 100));
+}
+
+// 是否有命令正在后台执行
+bool FileViewSubWindow::isProcessing() const
+{
+    return m_activeControl != nullptr;
+}
+
+// 协作式取消：任务在下一个行带开始前退出，结果被丢弃
+void FileViewSubWindow::cancelProcessing()
+{
+    if (!m_activeControl) return;
+
+    m_activeControl->cancel();
+    m_activeControl.reset();
+    m_progressTimer->stop();
+    m_progressBar->setVisible(false);
+}
+
+// 删除命令前等待仍在使用它的（已取消）任务结束
+void FileViewSubWindow::waitForJobsUsing(ImageCommand *command)
+{
+    for (const CommandJob &job : std::as_const(m_jobs)) {
+        if (job.command == command) {
+            job.control->cancel();
+            job.watcher->waitForFinished();
+        }
+    }
+}
+
 // 检查是否可以撤销
 bool FileViewSubWindow::canUndo() const
 {
@@ -140,21 +517,57 @@ bool FileViewSubWindow::canRedo() const
 // 撤销操作
 void FileViewSubWindow::undo()
 {
+    // 有命令正在执行时，撤销即取消该命令
+    if (isProcessing()) {
+        cancelProcessing();
+        return;
+    }
+
     if (!canUndo()) return;
+    if (m_videoProcessor) {
+        m_historyIndex--;
+        applyVideoChain();
+        emit commandApplied(getCurrentCommand());
+        return;
+    }
+    PERF_TRACE("FileViewSubWindow::undo");
+    QElapsedTimer timer;
+    timer.start();
+
+    // 上一步的快照（第 m_historyIndex 个）已被淘汰且未缓存：在后台从最近的保留快照重新计算，完成后重新保存
+    const int target = m_historyIndex;
+    const QImage previous = historyImage(target);
+    if (previous.isNull()) {
+        const int base = m_history->storedBase(target);
+        const QString cacheKey = ResultCache::key(m_history->snapshotId(target - 1),
+                                                  *m_commandHistory[target - 1]);
+        runChainAsync(m_commandHistory.mid(base, target - base), m_history->image(base), tr("撤销"),
+                      [this, target, cacheKey](const QImage &result) {
+            ResultCache::insert(cacheKey, result);
+            // 执行期间历史记录可能已变化，仅当仍停在原处时后退
+            if (m_historyIndex != target) return;
+            m_historyIndex--;
+            m_currentImage = result;
+            m_history->setCurrent(target, result);
+            emit commandApplied(m_commandHistory[m_historyIndex]);
+            updateImageDisplay();
+        }, nullptr);
+        return;
+    }
 
     m_historyIndex--;
+    m_currentImage = previous;
+    m_history->setCurrent(m_historyIndex + 1, previous);
 
-    // 如果没有历史记录，显示原始图片
+    // 如果没有历史记录，显示的是原始图片
     if (m_historyIndex < 0) {
-        m_currentImage = m_originalImage;
         emit commandApplied(nullptr); // 没有当前命令
     } else {
-        // 否则，显示上一个命令执行前的图片
-        m_currentImage = m_commandHistory[m_historyIndex]->undo();
-        emit commandApplied(m_historyIndex >= 0 ? m_commandHistory[m_historyIndex] : nullptr);
+        emit commandApplied(m_commandHistory[m_historyIndex]);
     }
 
     updateImageDisplay();
+    emit operationTimed(tr("撤销"), timer.nsecsElapsed(), PerfTrace::megapixels(m_currentImage.size()));
 }
 
 // 获取当前图像
@@ -176,15 +589,57 @@ ImageCommand* FileViewSubWindow::getCurrentCommand() const
 void FileViewSubWindow::redo()
 {
     if (!canRedo()) return;
+    if (m_videoProcessor) {
+        m_historyIndex++;
+        applyVideoChain();
+        emit commandApplied(getCurrentCommand());
+        return;
+    }
+    PERF_TRACE("FileViewSubWindow::redo");
+    QElapsedTimer timer;
+    timer.start();
+
+    ImageCommand *command = m_commandHistory[m_historyIndex + 1];
+
+    const QString cacheKey = ResultCache::key(m_history->snapshotId(m_historyIndex + 1), *command);
+
+    // 下一步的快照仍保存在历史中，或结果仍在缓存中时直接取用
+    QImage next;
+    if (!isProcessing()) {
+        if (m_history->isStored(m_historyIndex + 2)) {
+            next = m_history->image(m_historyIndex + 2);
+        } else {
+            ResultCache::lookup(cacheKey, &next);
+        }
+    }
+    if (!next.isNull()) {
+        m_historyIndex++;
+        m_currentImage = next;
+        m_history->setCurrent(m_historyIndex + 1, next);
+        updateImageDisplay();
+        emit commandApplied(command);
+        emit operationTimed(tr("重做"), timer.nsecsElapsed(), PerfTrace::megapixels(next.size()));
+        return;
+    }
 
-    m_historyIndex++;
+    // 快照已被淘汰且未缓存：以当前图片为输入在后台重新执行下一个命令
+    runCommandAsync(command, commandInput(m_currentImage), [this, command, cacheKey](const QImage &result) {
+        ResultCache::insert(cacheKey, result);
 
-    // 执行下一个命令
-    m_currentImage = m_commandHistory[m_historyIndex]->execute();
-    updateImageDisplay();
-    
-    // 发出命令应用信号
-    emit commandApplied(m_commandHistory[m_historyIndex]);
+        // 执行期间历史记录可能已变化，仅当它仍是下一步时前进
+        if (m_historyIndex + 1 >= m_commandHistory.size()
+            || m_commandHistory[m_historyIndex + 1] != command) {
+            return;
+        }
+
+        m_historyIndex++;
+        m_currentImage = result;
+        m_history->setCurrent(m_historyIndex + 1, result);
+        updateImageDisplay();
+
+        // 发出命令应用信号
+        emit commandApplied(command);
+    }, nullptr);
 }
 
 // 对外接口：设置缩放比例（1~500%）
@@ -192,7 +647,16 @@ void FileViewSubWindow::setScaleFactor(int percent)
 {
     // 限制范围：1% ~ 500%
     m_scalePercent = qBound(1, percent, 500);
-    updateImageDisplay();
+    scheduleZoom();
+}
+
+// 合并缩放请求：定时器未启动时启动，已启动时只更新比例，到时应用最新比例
+void FileViewSubWindow::scheduleZoom()
+{
+    if (!m_zoomTimer) return;
+    if (!m_zoomTimer->isActive()) {
+        m_zoomTimer->start();
+    }
 }
 
 // 获取当前缩放比例（%）
@@ -205,7 +669,7 @@ int FileViewSubWindow::currentScalePercent() const
 void FileViewSubWindow::wheelEvent(QWheelEvent *event)
 {
     // 仅图片模式下响应滚轮
-    if (m_originalImage.isNull()) {
+    if (!m_viewer) {
         QMdiSubWindow::wheelEvent(event);
         return;
     }
@@ -215,9 +679,9 @@ void FileViewSubWindow::wheelEvent(QWheelEvent *event)
     int newPercent = m_scalePercent + delta;
     newPercent = qBound(1, newPercent, 500);  // 限制范围
 
-    // 更新缩放并通知主窗口Slider同步
+    // 更新缩放并通知主窗口Slider同步（显示按帧合并更新）
     m_scalePercent = newPercent;
-    updateImageDisplay();
+    scheduleZoom();
     emit scaleChanged(m_scalePercent);  // 触发主窗口更新Slider（QMdiSubWindow内置信号）
 }
 // 格式化时间：毫秒 → 分:秒（如 123000ms → 2:03）
@@ -242,6 +706,10 @@ void FileViewSubWindow::loadVideo(const QString &filePath)
     m_videoWidget->setAspectRatioMode(Qt::KeepAspectRatio); // 保持视频比例
     m_mediaPlayer->setVideoOutput(m_videoWidget);
 
+    // 实时处理：应用命令后播放器改为输出到处理器，处理结果显示在视频控件上
+    m_videoProcessor = new VideoProcessor(m_videoWidget->videoSink(), this);
+    connect(m_videoProcessor, &VideoProcessor::statisticsChanged, this, &FileViewSubWindow::updateVideoStatistics);
+
     // 3. 创建视频控制栏（水平布局）
     QWidget *controlBar = new QWidget(this);
     QHBoxLayout *controlLayout = new QHBoxLayout(controlBar);
@@ -266,7 +734,7 @@ void FileViewSubWindow::loadVideo(const QString &filePath)
 
     // 3.3 进度条（保持Expanding策略，占满剩余空间）
     m_sliderProgress = new QSlider(Qt::Horizontal, this);
-    m_sliderProgress->setRange(0, 100);
+    m_sliderProgress->setRange(0, 0);
     m_sliderProgress->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     controlLayout->addWidget(m_sliderProgress);
 
@@ -276,6 +744,11 @@ void FileViewSubWindow::loadVideo(const QString &filePath)
     m_labelTime->setAlignment(Qt::AlignCenter);
     controlLayout->addWidget(m_labelTime);
 
+    // 3.5 实时处理统计（应用命令后显示）
+    m_labelVideoStats = new QLabel(this);
+    m_labelVideoStats->setVisible(false);
+    controlLayout->addWidget(m_labelVideoStats);
+
     // 4. 复用构造函数的布局，添加视频控件和控制栏
     QVBoxLayout *mainLayout = qobject_cast<QVBoxLayout*>(m_contentWidget->layout());
     if (mainLayout) {
@@ -286,13 +759,32 @@ void FileViewSubWindow::loadVideo(const QString &filePath)
     // 5. 设置媒体源（Qt6 标准）
     m_mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
 
+    // 5.1 拖动进度条：立即显示缩略图索引中最近的帧，停顿后才定位
+    m_scrubThumbnail = new QLabel(this, Qt::ToolTip);
+    m_scrubThumbnail->setAlignment(Qt::AlignCenter);
+    m_scrubThumbnail->setVisible(false);
+    m_seekSettleTimer = new QTimer(this);
+    m_seekSettleTimer->setInterval(SeekSettleMs);
+    m_seekSettleTimer->setSingleShot(true);
+    connect(m_seekSettleTimer, &QTimer::timeout, this, [this]() { seekTo(m_sliderProgress->value()); });
+
+    m_videoIndexer = new VideoIndexer(filePath, this);
+    connect(m_videoIndexer, &VideoIndexer::updated, this, [this]() {
+        if (m_isProgressDragging) showScrubThumbnail(m_sliderProgress->value());
+    });
+    m_videoIndexer->start();
+
     // 6. 关联信号槽（核心控制逻辑）
     // 播放/暂停按钮
     connect(m_btnPlayPause, &QPushButton::clicked, this, &FileViewSubWindow::onPlayPauseClicked);
     // 音量滑块
     connect(m_sliderVolume, &QSlider::valueChanged, this, &FileViewSubWindow::onVolumeSliderChanged);
     // 进度条（拖动时标记，释放时更新位置，避免实时卡顿）
-    connect(m_sliderProgress, &QSlider::sliderPressed, this, [=]() { m_isProgressDragging = true; });
+    // 每次拖动重新开始去重：拖回之前定位过的位置（如拖到0重新开始）时照常定位
+    connect(m_sliderProgress, &QSlider::sliderPressed, this, [=]() {
+        m_isProgressDragging = true;
+        m_lastSeekPosition = -1;
+    });
     connect(m_sliderProgress, &QSlider::sliderReleased, this, &FileViewSubWindow::onProgressSliderReleased);
     connect(m_sliderProgress, &QSlider::valueChanged, this, &FileViewSubWindow::onProgressSliderChanged);
     // 播放器状态变化（更新按钮图标）
@@ -331,10 +823,14 @@ void FileViewSubWindow::onVolumeSliderChanged(int value)
     m_audioOutput->setVolume(value / 100.0); // Qt6 音量范围 0.0~1.0
 }
 
-// 进度条拖动（仅记录值，释放时更新）
+// 进度条拖动：立即显示最近的缩略图，拖动停顿 SeekSettleMs 后定位一次
 void FileViewSubWindow::onProgressSliderChanged(int value)
 {
-    if (!m_mediaPlayer || m_isProgressDragging) return; // 拖动时不实时更新，避免卡顿
+    if (!m_mediaPlayer || !m_isProgressDragging) return;
+
+    showScrubThumbnail(value);
+    m_labelTime->setText(QString("%1/%2").arg(formatTime(value)).arg(formatTime(m_mediaPlayer->duration())));
+    m_seekSettleTimer->start();
 }
 
 // 进度条释放（更新视频播放位置）
@@ -343,12 +839,35 @@ void FileViewSubWindow::onProgressSliderReleased()
     if (!m_mediaPlayer) return;
 
     m_isProgressDragging = false;
-    qint64 duration = m_mediaPlayer->duration();
-    if (duration <= 0) return;
+    m_seekSettleTimer->stop();
+    m_scrubThumbnail->setVisible(false);
+    seekTo(m_sliderProgress->value());
+}
 
-    // 计算目标位置（进度条值 → 毫秒）
-    qint64 targetPos = (m_sliderProgress->value() * duration) / 100;
-    m_mediaPlayer->setPosition(targetPos); // 更新播放位置
+void FileViewSubWindow::seekTo(qint64 position)
+{
+    if (!m_mediaPlayer || m_mediaPlayer->duration() <= 0 || position == m_lastSeekPosition) return;
+    m_lastSeekPosition = position;
+    m_mediaPlayer->setPosition(position);
+}
+
+// 缩略图浮窗跟随滑块手柄；索引尚在建立时使用已有的部分
+void FileViewSubWindow::showScrubThumbnail(qint64 position)
+{
+    const VideoIndex &index = m_videoIndexer->index();
+    const int i = index.nearest(position);
+    if (i < 0) {
+        m_scrubThumbnail->setVisible(false);
+        return;
+    }
+
+    m_scrubThumbnail->setPixmap(QPixmap::fromImage(index.thumbnail(i)));
+    m_scrubThumbnail->adjustSize();
+    const int x = QStyle::sliderPositionFromValue(m_sliderProgress->minimum(), m_sliderProgress->maximum(),
+                                                  int(position), m_sliderProgress->width());
+    const QPoint anchor = m_sliderProgress->mapToGlobal(QPoint(x, 0));
+    m_scrubThumbnail->move(anchor.x() - m_scrubThumbnail->width() / 2, anchor.y() - m_scrubThumbnail->height() - 4);
+    m_scrubThumbnail->setVisible(true);
 }
 
 // 播放状态变化（更新按钮图标）
@@ -370,8 +889,8 @@ void FileViewSubWindow::onDurationChanged(qint64 duration)
 {
     if (!m_sliderProgress || !m_labelTime) return;
 
-    // 进度条范围设为 0~100（百分比），方便计算
-    m_sliderProgress->setRange(0, 100);
+    // 进度条以毫秒为单位，拖动精度不受步数限制
+    m_sliderProgress->setRange(0, int(qMin<qint64>(duration, std::numeric_limits<int>::max())));
     // 更新总时长显示
     m_labelTime->setText(QString("%1/%2").arg("0:00").arg(formatTime(duration)));
 }
@@ -384,10 +903,65 @@ void FileViewSubWindow::onPositionChanged(qint64 position)
     qint64 duration = m_mediaPlayer->duration();
     if (duration <= 0) return;
 
-    // 计算进度百分比（0~100）
-    int progress = qRound((position * 100.0) / duration);
-    m_sliderProgress->setValue(progress);
+    m_sliderProgress->setValue(int(position));
 
     // 更新时间显示（当前/总时长）
     m_labelTime->setText(QString("%1/%2").arg(formatTime(position)).arg(formatTime(duration)));
 }
+
+// 命令链变化：链为空时恢复播放器直接输出，否则经处理器输出；暂停时当前帧随之重新处理
+void FileViewSubWindow::applyVideoChain()
+{
+    if (!m_videoProcessor || !m_mediaPlayer) return;
+
+    const QList<ImageCommand *> chain = m_commandHistory.mid(0, m_historyIndex + 1);
+    if (chain.isEmpty()) {
+        // 旁路期间可能定位到别处，处理器中保留的帧已过时
+        m_videoProcessor->clear();
+        m_videoProcessor->setCommands(chain);
+        m_mediaPlayer->setVideoOutput(m_videoWidget);
+        m_labelVideoStats->setVisible(false);
+        return;
+    }
+    m_videoProcessor->setCommands(chain);
+    if (m_mediaPlayer->videoSink() != m_videoProcessor->inputSink()) {
+        m_mediaPlayer->setVideoSink(m_videoProcessor->inputSink());
+        m_videoProcessor->resetStatistics();
+        m_labelVideoStats->setVisible(true);
+        // 暂停时播放器不会再送帧：定位到当前位置，让当前画面经处理后显示
+        if (m_mediaPlayer->playbackState() != QMediaPlayer::PlayingState) {
+            m_mediaPlayer->setPosition(m_mediaPlayer->position());
+        }
+    }
+}
+
+// 帧耗时（最近/平均）和丢帧数
+void FileViewSubWindow::updateVideoStatistics()
+{
+    if (!m_labelVideoStats || !m_labelVideoStats->isVisible()) return;
+    m_labelVideoStats->setText(tr("帧耗时 %1 ms（平均 %2 ms），丢帧 %3/%4")
+                                   .arg(m_videoProcessor->lastFrameMs(), 0, 'f', 1)
+                                   .arg(m_videoProcessor->averageFrameMs(), 0, 'f', 1)
+                                   .arg(m_videoProcessor->droppedFrames())
+                                   .arg(m_videoProcessor->droppedFrames() + m_videoProcessor->presentedFrames()));
+}
+
+bool FileViewSubWindow::canExportVideo() const
+{
+    return m_videoProcessor && !m_videoExporter && m_historyIndex >= 0;
+}
+
+// 离线导出当前处理链：导出器独立解码源文件，不影响窗口中的播放
+VideoExporter *FileViewSubWindow::exportVideo(const QString &outputPath)
+{
+    if (!canExportVideo()) return nullptr;
+
+    m_videoExporter = new VideoExporter(m_mediaPlayer->source(), m_commandHistory.mid(0, m_historyIndex + 1), this);
+    VideoExporter *exporter = m_videoExporter;
+    connect(exporter, &VideoExporter::finished, this, [this, exporter]() {
+        exporter->deleteLater();
+        if (m_videoExporter == exporter) m_videoExporter = nullptr;
+    });
+    m_videoExporter->start(outputPath);
+    return m_videoExporter;
+}
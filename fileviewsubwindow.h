@@ -17,7 +17,21 @@
 #include <QHBoxLayout>
 #include <QString>
 #include <QList>
+#include <QProgressBar>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
 #include "imagecommand.h"
+#include "imagehistory.h"
+#include "imagepyramid.h"
+#include "imageviewer.h"
+#include "imageloader.h"
+#include "taskcontrol.h"
+#include "videoexporter.h"
+#include "videoindexer.h"
+#include "videoprocessor.h"
 
 class FileViewSubWindow final : public QMdiSubWindow
 {
@@ -27,7 +41,7 @@ class FileViewSubWindow final : public QMdiSubWindow
 public:
     // 构造函数：explicit避免隐式转换，QWidget* parent = nullptr符合Qt6默认参数规范
     explicit FileViewSubWindow(const QString &filePath, QWidget *parent = nullptr);
-    ~FileViewSubWindow() override = default;  // 显式默认析构，符合现代C++
+    ~FileViewSubWindow() override;  // 取消并等待后台任务
 
     // 对外暴露缩放接口（供MainWindow的Slider调用）
     void setScaleFactor(int percent);  // 入参：1~500（对应1%~500%）
@@ -40,13 +54,18 @@ protected:
 signals:
     void scaleChanged(int percent);  // 缩放比例变化时触发，携带当前比例
     void commandApplied(ImageCommand *command);  // 命令应用或撤销/重做时触发
+    void imageReady();  // 完整图片解码完成，命令可用
+    void previewReady();  // 首次有可显示的内容（预览或完整图片），只触发一次
+    void loadFinished(bool ok);  // 图片加载结束（成功或失败）
+    // 一次操作（打开、命令、撤销/重做）完成：耗时（纳秒）和处理的百万像素数
+    void operationTimed(const QString &name, qint64 nsecs, double megapixels);
 
 
 private slots:
     // 新增视频控制槽函数
     void onPlayPauseClicked();       // 播放/暂停切换
     void onVolumeSliderChanged(int value); // 音量调节
-    void onProgressSliderChanged(int value); // 进度条拖动
+    void onProgressSliderChanged(int value); // 进度条拖动（显示最近的缩略图，停顿后定位一次）
     void onProgressSliderReleased(); // 进度条释放（避免实时卡顿）
     void onPlayerStateChanged(QMediaPlayer::PlaybackState state); // 播放状态变化
     void onDurationChanged(qint64 duration); // 视频时长变化
@@ -63,36 +82,110 @@ public:
     void undo();
     void redo();
     ImageCommand* getCurrentCommand() const;  // 获取当前应用的命令
+    bool isImageReady() const;  // 完整图片是否已解码（加载期间只显示预览）
+    bool acceptsCommands() const;  // 图片已解码，或为视频窗口（命令加入实时处理链，导出期间不可用）
+
+    // 视频窗口：按当前处理链离线导出到文件，返回导出器（结束后自行删除）；非视频窗口或链为空时返回 nullptr
+    VideoExporter *exportVideo(const QString &outputPath);
+    bool canExportVideo() const;
+    bool hasPreview() const;    // 是否已有可显示的内容
+    bool isProcessing() const;  // 是否有命令正在后台执行
+    void cancelProcessing();    // 协作式取消正在执行的命令
+
+    // 拖动参数滑块时的实时预览：在与屏幕显示尺寸相当的低分辨率代理图上执行命令
+    QImage previewSource();
+    void previewCommand(const ImageCommand &command);
 
 private:
     // 加载媒体文件的私有方法
-    void loadImage(const QString &filePath);  // 加载图片（JPG/PNG/BMP）
+    void loadImage(const QString &filePath);  // 加载图片（JPG/PNG/BMP），后台解码
+    void finishLoading(const QString &filePath, const QImage &image);  // 完整解码完成
+    void initScale(const QSize &imageSize);  // 按图片尺寸计算初始缩放比例
+    void notifyPreviewReady();
     void loadVideo(const QString &filePath);  // 加载视频（MP4/AVI/MOV）
     void updateImageDisplay();  // 刷新图片显示（核心：保持比例）
+    QImage displaySource(const QSize &targetSize);  // 缩放到 targetSize 时使用的金字塔层级
+    void ensurePyramid();       // 当前图片的金字塔过期时在后台重建
+    void scheduleZoom();        // 合并连续的缩放请求，每帧最多应用一次
     // 新增：格式化时间（毫秒转 分:秒，如 1:23）
     QString formatTime(qint64 ms);
+    // 视频窗口：命令历史中当前位置之前的命令即实时处理链，链为空时播放器直接输出到视频控件
+    void applyVideoChain();
+    void updateVideoStatistics();  // 刷新帧耗时和丢帧显示
+    void showScrubThumbnail(qint64 position);  // 拖动进度条时在滑块上方显示最接近的缩略图
+    void seekTo(qint64 position);  // 定位播放位置（一次拖动中同一位置只定位一次）
+    // 在后台线程执行命令，完成后在GUI线程回调；被更新的任务取消时调用 onCancelled
+    void runCommandAsync(ImageCommand *command, const QImage &input,
+                         std::function<void(const QImage &)> onFinished,
+                         std::function<void()> onCancelled);
+    // 同上，依次执行命令链（name 为状态栏显示的操作名）
+    void runChainAsync(const QList<ImageCommand *> &chain, const QImage &input, const QString &name,
+                       std::function<void(const QImage &)> onFinished,
+                       std::function<void()> onCancelled);
+    void updateProgress();  // 刷新进度条
+    void waitForJobsUsing(ImageCommand *command);  // 删除命令前等待仍在使用它的任务结束
+    void commitCommand(ImageCommand *command, const QImage &result);  // 命令结果加入历史记录
+    QImage commandInput(const QImage &input);  // 命令输入为当前图片时换成规范格式（只转换一次）
+    QImage historyImage(int index);  // 取出历史快照（已淘汰时查结果缓存），都没有时返回空图像
 
     // 缩放相关成员变量
-    QImage m_originalImage;     // 保存原始图片
     QImage m_currentImage;      // 当前显示的图片
     int m_scalePercent = 100;   // 当前缩放比例（默认100%）
+    QTimer *m_zoomTimer = nullptr;  // 缩放合并定时器（约一帧）
+    bool m_scaleInitialized = false;
+    bool m_previewNotified = false;
+    QElapsedTimer m_operationTimer;  // 打开文件的耗时
+    static constexpr int PreviewSide = 2048;  // 加载预览的最大边长
+
+    // 当前图片的显示金字塔（后台构建，图片变化后过期）
+    ImagePyramid m_pyramid;
+    qint64 m_pyramidPendingKey = 0;  // 正在构建的金字塔对应的图片
+
+    // 预览代理图（按当前图片和缩放比例缓存）
+    QImage m_proxyImage;
+    qint64 m_proxyKey = 0;
+    int m_proxyScalePercent = 0;
 
     // 命令历史记录
     QList<ImageCommand*> m_commandHistory;
     int m_historyIndex = -1;     // 当前历史记录索引
+    // 各步结果的分块快照（第0个为原图，第 i+1 个为第 i 个命令的结果），仅图片模式下存在
+    std::unique_ptr<ImageHistory> m_history;
+
+    // 后台任务：被取消的任务可能仍在运行，全部记录以便析构时等待
+    struct CommandJob
+    {
+        QFutureWatcher<QImage> *watcher = nullptr;
+        ImageCommand *command = nullptr;  // 命令链时为最后一个命令（命令从历史末尾开始删除）
+        std::shared_ptr<TaskControl> control;
+        std::function<void()> onCancelled;
+    };
+    QList<CommandJob> m_jobs;
+    std::shared_ptr<TaskControl> m_activeControl;  // 最新（未被取代）的任务
+    QProgressBar *m_progressBar = nullptr;
+    QTimer *m_progressTimer = nullptr;
 
     // 成员变量：使用前向声明+初始化，遵循Qt6内存管理（父子机制）
     QWidget *m_contentWidget = nullptr;
-    QLabel *m_imageLabel = nullptr;
+    QLabel *m_imageLabel = nullptr;        // 加载失败时的提示
+    ImageViewer *m_viewer = nullptr;       // 图片显示（按视口分块绘制）
     // 视频相关成员
     QMediaPlayer *m_mediaPlayer = nullptr;
     QVideoWidget *m_videoWidget = nullptr;
     QAudioOutput *m_audioOutput = nullptr;   // Qt6 音频输出（替代原setVolume）
     QPushButton *m_btnPlayPause = nullptr; // 播放/暂停按钮
     QSlider *m_sliderVolume = nullptr;     // 音量滑块（0~100）
-    QSlider *m_sliderProgress = nullptr;   // 进度条（0~视频时长）
+    QSlider *m_sliderProgress = nullptr;   // 进度条（0~视频时长，单位毫秒）
     QLabel *m_labelTime = nullptr;         // 时间显示（当前/总时长）
+    QLabel *m_labelVideoStats = nullptr;   // 实时处理的帧耗时和丢帧数
+    VideoProcessor *m_videoProcessor = nullptr;  // 实时处理（命令链非空时接管播放器的视频输出）
+    VideoExporter *m_videoExporter = nullptr;    // 正在进行的导出（使用历史中的命令，导出期间不修改历史）
     bool m_isProgressDragging = false;     // 进度条拖动标记（避免卡顿）
+    VideoIndexer *m_videoIndexer = nullptr; // 后台建立的缩略图索引（带磁盘缓存）
+    QLabel *m_scrubThumbnail = nullptr;     // 拖动时的缩略图浮窗
+    QTimer *m_seekSettleTimer = nullptr;    // 拖动停顿后才定位，避免每个滑块值都定位一次
+    qint64 m_lastSeekPosition = -1;         // 本次拖动中最近定位的位置（按下滑块时清除）
+    static constexpr int SeekSettleMs = 150;
 };
 
 #endif // FILEVIEWSUBWINDOW_H
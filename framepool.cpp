@@ -0,0 +1,121 @@
+#include "framepool.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+
+qsizetype alignUp(qsizetype value, qsizetype alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+struct FramePool::Shared
+{
+    struct Slot
+    {
+        Shared *shared = nullptr;
+        std::unique_ptr<uchar[]> storage;
+        qsizetype bytes = 0;  // 对齐后可用的字节数
+        uchar *data = nullptr;
+        bool inUse = false;
+    };
+
+    QMutex mutex;
+    std::vector<Slot> slots;
+    int outstanding = 0;
+    bool closed = false;  // 池已析构，最后一个缓冲区归还时删除
+    qint64 allocations = 0;
+
+    // QImage 的清理回调：归还缓冲区
+    static void release(void *info)
+    {
+        Slot *slot = static_cast<Slot *>(info);
+        Shared *shared = slot->shared;
+        bool destroy;
+        {
+            QMutexLocker locker(&shared->mutex);
+            slot->inUse = false;
+            destroy = --shared->outstanding == 0 && shared->closed;
+        }
+        if (destroy) delete shared;
+    }
+};
+
+FramePool::FramePool(int capacity)
+    : m_shared(new Shared)
+{
+    m_shared->slots.resize(size_t(qMax(1, capacity)));
+    for (Shared::Slot &slot : m_shared->slots) {
+        slot.shared = m_shared;
+    }
+}
+
+FramePool::~FramePool()
+{
+    bool destroy;
+    {
+        QMutexLocker locker(&m_shared->mutex);
+        m_shared->closed = true;
+        destroy = m_shared->outstanding == 0;
+    }
+    if (destroy) delete m_shared;
+}
+
+QImage FramePool::acquire(const QSize &size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid) return QImage();
+
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qsizetype bytesPerLine = alignUp((qsizetype(size.width()) * depth + 7) / 8, Alignment);
+    const qsizetype bytes = bytesPerLine * size.height();
+
+    Shared::Slot *slot = nullptr;
+    {
+        QMutexLocker locker(&m_shared->mutex);
+        // 优先取容量足够的空闲缓冲区，没有时重新分配第一个空闲的
+        Shared::Slot *fallback = nullptr;
+        for (Shared::Slot &candidate : m_shared->slots) {
+            if (candidate.inUse) continue;
+            if (candidate.bytes >= bytes) {
+                slot = &candidate;
+                break;
+            }
+            if (!fallback) fallback = &candidate;
+        }
+        if (!slot) slot = fallback;
+        if (!slot) return QImage();
+        slot->inUse = true;
+        ++m_shared->outstanding;
+        if (slot->bytes < bytes) ++m_shared->allocations;
+    }
+
+    // 空闲缓冲区只由当前线程持有，在锁外分配
+    if (slot->bytes < bytes) {
+        slot->storage.reset(new (std::nothrow) uchar[size_t(bytes + Alignment)]);
+        if (!slot->storage) {
+            slot->bytes = 0;
+            Shared::release(slot);
+            return QImage();
+        }
+        slot->bytes = bytes;
+        slot->data = reinterpret_cast<uchar *>(alignUp(qsizetype(quintptr(slot->storage.get())), Alignment));
+    }
+
+    return QImage(slot->data, size.width(), size.height(), bytesPerLine, format, &Shared::release, slot);
+}
+
+int FramePool::capacity() const
+{
+    return int(m_shared->slots.size());
+}
+
+qint64 FramePool::allocations() const
+{
+    QMutexLocker locker(&m_shared->mutex);
+    return m_shared->allocations;
+}
@@ -0,0 +1,32 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QSize>
+
+// 固定容量的图像缓冲池（可在任意线程使用）
+// acquire() 取一个空闲缓冲区包装为 QImage（外部缓冲，不复制），该图像及其全部副本释放后缓冲区自动归还；
+// 缓冲区只在尺寸或格式变大时重新分配，尺寸稳定的连续帧处理不再分配像素内存
+// 行首按 Alignment 字节对齐；缓冲区全部占用时返回空图像，调用者退回普通分配
+// 池析构时仍在使用的缓冲区在最后一个图像释放后再回收
+class FramePool
+{
+public:
+    static constexpr int DefaultCapacity = 8;
+    static constexpr int Alignment = 64;
+
+    explicit FramePool(int capacity = DefaultCapacity);
+    ~FramePool();
+    Q_DISABLE_COPY_MOVE(FramePool)
+
+    QImage acquire(const QSize &size, QImage::Format format);
+
+    int capacity() const;
+    qint64 allocations() const;  // 分配（含重新分配）像素内存的次数
+
+private:
+    struct Shared;
+    Shared *m_shared;
+};
+
+#endif // FRAMEPOOL_H
@@ -7,7 +7,9 @@ class GammaCorrectionCommand : public ImageCommand
 {
 public:
     GammaCorrectionCommand(const QImage &originalImage, double gamma);
-    QImage execute() override;
+    QImage apply(const QImage &input) const override;
+    std::optional<PointOperation> pointOperation() const override;
+    QString cacheKey() const override;
     double gamma() const;
 
 private:
@@ -5,20 +5,13 @@ GrayscaleCommand::GrayscaleCommand(const QImage &originalImage)
 {
 }
 
-QImage GrayscaleCommand::execute()
+QImage GrayscaleCommand::apply(const QImage &input) const
 {
-    QImage resultImage = m_originalImage.copy();
-
-    // 遍历每个像素
-    for (int y = 0; y < resultImage.height(); ++y) {
-        for (int x = 0; x < resultImage.width(); ++x) {
-            QColor pixelColor = resultImage.pixelColor(x, y);
-            // 计算灰度值：(R+G+B)/3
-            int grayValue = (pixelColor.red() + pixelColor.green() + pixelColor.blue()) / 3;
-            // 设置灰度像素
-            resultImage.setPixelColor(x, y, QColor(grayValue, grayValue, grayValue));
-        }
-    }
+    // 灰度值：(R+G+B)/3，输出单字节灰度图（Format_Grayscale8）
+    return PointOperation::grayscale().apply(input);
+}
 
-    return resultImage;
+std::optional<PointOperation> GrayscaleCommand::pointOperation() const
+{
+    return PointOperation::grayscale();
 }
@@ -7,7 +7,8 @@ class GrayscaleCommand : public ImageCommand
 {
 public:
     explicit GrayscaleCommand(const QImage &originalImage);
-    QImage execute() override;
+    QImage apply(const QImage &input) const override;
+    std::optional<PointOperation> pointOperation() const override;
 };
 
 #endif // GRAYSCALECOMMAND_H
\ No newline at end of file
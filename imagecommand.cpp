@@ -1,16 +1,91 @@
 #include "imagecommand.h"
+#include "framepool.h"
+#include "perftrace.h"
 
 ImageCommand::ImageCommand(const QImage &originalImage, const QString &name)
     : m_originalImage(originalImage), m_name(name)
 {
 }
 
+QImage ImageCommand::execute()
+{
+    PerfTrace::Scope trace("ImageCommand::execute", PerfTrace::megapixels(m_originalImage.size()));
+    if (trace.isActive()) trace.setDetail(m_name);
+    return apply(m_originalImage);
+}
+
 QImage ImageCommand::undo() const
 {
     return m_originalImage;
 }
 
+void ImageCommand::releaseOriginalImage()
+{
+    m_originalImage = QImage();
+}
+
 QString ImageCommand::name() const
 {
     return m_name;
 }
+
+QString ImageCommand::cacheKey() const
+{
+    return m_name;
+}
+
+QImage ImageCommand::applyInto(const QImage &input, QImage target) const
+{
+    Q_UNUSED(target);
+    return apply(input);
+}
+
+QImage::Format ImageCommand::resultFormat(const QImage &input) const
+{
+    Q_UNUSED(input);
+    return QImage::Format_Invalid;
+}
+
+std::optional<PointOperation> ImageCommand::pointOperation() const
+{
+    return std::nullopt;
+}
+
+bool ImageCommand::readsGrayOnly() const
+{
+    const std::optional<PointOperation> op = pointOperation();
+    return op && op->readsGrayOnly();
+}
+
+QImage ImageCommand::applyChain(const QList<ImageCommand *> &commands, const QImage &input, FramePool *pool)
+{
+    // 缓冲池中取与输入同尺寸的输出缓冲区，不支持或池已用尽时为空（由各步自行分配）
+    auto acquire = [pool](const QImage &image, QImage::Format format) {
+        return pool && format != QImage::Format_Invalid ? pool->acquire(image.size(), format) : QImage();
+    };
+
+    QImage image = input;
+    std::optional<PointOperation> pending;  // 尚未执行的融合点运算
+
+    for (const ImageCommand *command : commands) {
+        const std::optional<PointOperation> op = command->pointOperation();
+        if (op) {
+            pending = pending ? pending->then(*op) : *op;
+            continue;
+        }
+        if (pending) {
+            PERF_TRACE("PointOperation::apply", PerfTrace::megapixels(image.size()));
+            image = pending->apply(image, acquire(image, pending->resultFormat(image)));
+            pending.reset();
+        }
+        PerfTrace::Scope trace("ImageCommand::apply", PerfTrace::megapixels(image.size()));
+        if (trace.isActive()) trace.setDetail(command->name());
+        image = command->applyInto(image, acquire(image, command->resultFormat(image)));
+    }
+
+    if (pending) {
+        PERF_TRACE("PointOperation::apply", PerfTrace::megapixels(image.size()));
+        image = pending->apply(image, acquire(image, pending->resultFormat(image)));
+    }
+    return image;
+}
@@ -3,6 +3,11 @@
 
 #include <QImage>
 #include <QString>
+#include <QList>
+#include <optional>
+#include "pointoperation.h"
+
+class FramePool;
 
 class ImageCommand
 {
@@ -10,16 +15,39 @@ public:
     ImageCommand(const QImage &originalImage, const QString &name);
     virtual ~ImageCommand() = default;
 
-    // 执行命令
-    virtual QImage execute() = 0;
-    // 撤销命令
+    // 执行命令（作用于构造时传入的原始图像）
+    QImage execute();
+    // 对任意输入执行命令，不修改命令状态
+    virtual QImage apply(const QImage &input) const = 0;
+    // 同 apply()，输出写入调用者预先分配的 target（如 FramePool 的缓冲区，须为唯一引用）；
+    // target 的尺寸与格式须与输入尺寸和 resultFormat() 一致，否则忽略。默认实现忽略 target
+    virtual QImage applyInto(const QImage &input, QImage target) const;
+    // applyInto() 可写入的输出格式；不支持预分配输出的命令返回 Format_Invalid
+    virtual QImage::Format resultFormat(const QImage &input) const;
+    // 撤销命令（返回执行前的图像；释放后返回空图像）
     QImage undo() const;
+    // 加入历史记录后由 ImageHistory 保存执行前的图像，命令不再持有整图副本
+    void releaseOriginalImage();
     // 获取命令名称
     QString name() const;
 
+    // 命令标识：名称加全部参数，参数相同的命令对同一输入的结果相同（用于结果缓存）
+    virtual QString cacheKey() const;
+
+    // 点运算命令返回其查找表表示，供相邻命令融合；其他命令返回空
+    virtual std::optional<PointOperation> pointOperation() const;
+
+    // 结果只取决于输入的灰度（先归约为灰度再处理），灰度图（如视频帧的亮度平面）可直接作为输入
+    virtual bool readsGrayOnly() const;
+
+    // 依次执行命令链，相邻的点运算合成为一次单遍查找表变换
+    // 给出 pool 时，支持预分配输出的各步（含融合的点运算）从缓冲池取输出缓冲区，中间结果用完即归还
+    static QImage applyChain(const QList<ImageCommand *> &commands, const QImage &input,
+                             FramePool *pool = nullptr);
+
 protected:
     QImage m_originalImage;
     QString m_name;
 };
 
-#endif // IMAGECOMMAND_H
\ No newline at end of file
+#endif // IMAGECOMMAND_H
@@ -0,0 +1,403 @@
+#include "imagehistory.h"
+#include "tilescheduler.h"
+#include <QSet>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+std::atomic<qsizetype> g_defaultBudget { qsizetype(1) << 30 };  // 单文档 1 GB
+std::atomic<qsizetype> g_globalBudget { qsizetype(4) << 30 };   // 全局 4 GB
+std::atomic<quint64> g_sequence { 0 };
+
+// 所有存活的历史记录（仅在GUI线程访问），用于全局预算
+QList<ImageHistory *> &registry()
+{
+    static QList<ImageHistory *> histories;
+    return histories;
+}
+
+int tileCount(int length)
+{
+    return (length + ImageHistory::TileSize - 1) / ImageHistory::TileSize;
+}
+
+// 以 MB 为单位的预算环境变量，未设置或无效时返回 -1
+qsizetype budgetFromEnvironment(const char *name)
+{
+    bool ok = false;
+    const qlonglong megabytes = qEnvironmentVariable(name).toLongLong(&ok);
+    return ok && megabytes >= 0 ? qsizetype(megabytes) << 20 : -1;
+}
+
+} // namespace
+
+ImageHistory::ImageHistory(const QImage &original)
+    : m_budget(g_defaultBudget.load())
+{
+    Snapshot snapshot;
+    snapshot.live = original;
+    snapshot.sequence = g_sequence++;
+    m_snapshots.append(snapshot);
+    registry().append(this);
+    enforceBudgets();
+}
+
+ImageHistory::~ImageHistory()
+{
+    registry().removeOne(this);
+}
+
+int ImageHistory::count() const
+{
+    return m_snapshots.size();
+}
+
+void ImageHistory::truncate(int count)
+{
+    count = qMax(1, count);
+    if (count < m_snapshots.size()) {
+        m_snapshots.resize(count);
+    }
+    m_current = qMin(m_current, count - 1);
+}
+
+void ImageHistory::append(const QImage &image)
+{
+    settle(m_current);
+    Snapshot snapshot;
+    snapshot.live = image;
+    snapshot.sequence = g_sequence++;
+    m_snapshots.append(snapshot);
+    m_current = int(m_snapshots.size()) - 1;
+
+    compressOlder();
+    enforceBudgets();
+}
+
+void ImageHistory::setCurrent(int index, const QImage &image)
+{
+    index = qBound(0, index, int(m_snapshots.size()) - 1);
+    if (index != m_current) {
+        settle(m_current);
+        m_current = index;
+    }
+    Snapshot &snapshot = m_snapshots[index];
+    if (!snapshot.isStored() && !image.isNull()) {
+        snapshot.live = image;
+        enforceBudgets();
+    }
+}
+
+void ImageHistory::replaceCurrent(const QImage &image)
+{
+    if (image.isNull()) return;
+    Snapshot &snapshot = m_snapshots[m_current];
+    snapshot.tiles.clear();
+    snapshot.live = image;
+    enforceBudgets();
+}
+
+bool ImageHistory::isStored(int index) const
+{
+    return index >= 0 && index < m_snapshots.size() && m_snapshots[index].isStored();
+}
+
+quint64 ImageHistory::snapshotId(int index) const
+{
+    return m_snapshots[index].sequence;
+}
+
+QImage ImageHistory::image(int index) const
+{
+    if (index < 0 || index >= m_snapshots.size()) return QImage();
+    return toImage(m_snapshots[index]);
+}
+
+int ImageHistory::storedBase(int index) const
+{
+    int base = qBound(0, index, int(m_snapshots.size()) - 1);
+    while (base > 0 && !m_snapshots[base].isStored()) {
+        --base;
+    }
+    return base;
+}
+
+qsizetype ImageHistory::memoryBytes() const
+{
+    QSet<const Tile *> counted;
+    qsizetype bytes = 0;
+    for (const Snapshot &snapshot : m_snapshots) {
+        bytes += snapshot.live.sizeInBytes();
+        for (const TilePtr &tile : snapshot.tiles) {
+            if (!counted.contains(tile.get())) {
+                counted.insert(tile.get());
+                bytes += tile->data.size();
+            }
+        }
+    }
+    return bytes;
+}
+
+void ImageHistory::setBudget(qsizetype bytes)
+{
+    m_budget = qMax<qsizetype>(0, bytes);
+    enforceBudgets();
+}
+
+qsizetype ImageHistory::budget() const
+{
+    return m_budget;
+}
+
+void ImageHistory::setDefaultBudget(qsizetype bytes)
+{
+    g_defaultBudget = qMax<qsizetype>(0, bytes);
+}
+
+qsizetype ImageHistory::defaultBudget()
+{
+    return g_defaultBudget.load();
+}
+
+void ImageHistory::setGlobalBudget(qsizetype bytes)
+{
+    g_globalBudget = qMax<qsizetype>(0, bytes);
+    if (!registry().isEmpty()) {
+        registry().first()->enforceBudgets();
+    }
+}
+
+qsizetype ImageHistory::globalBudget()
+{
+    return g_globalBudget.load();
+}
+
+qsizetype ImageHistory::globalMemoryBytes()
+{
+    qsizetype bytes = 0;
+    for (const ImageHistory *history : std::as_const(registry())) {
+        bytes += history->memoryBytes();
+    }
+    return bytes;
+}
+
+void ImageHistory::initFromEnvironment()
+{
+    const qsizetype budget = budgetFromEnvironment("PSVIDIO_HISTORY_BUDGET_MB");
+    if (budget >= 0) setDefaultBudget(budget);
+    const qsizetype global = budgetFromEnvironment("PSVIDIO_HISTORY_GLOBAL_BUDGET_MB");
+    if (global >= 0) setGlobalBudget(global);
+}
+
+// 切块保存；与上一快照（尺寸、格式相同时）逐块比较，内容相同的块直接共享
+ImageHistory::Snapshot ImageHistory::makeSnapshot(const QImage &input, const Snapshot *previous)
+{
+    Snapshot snapshot;
+    if (input.isNull()) return snapshot;
+
+    // 按字节切块，不足一字节的格式先转换为32位
+    QImage image = input;
+    if (image.depth() < 8) {
+        image = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                               : QImage::Format_RGB32);
+    }
+
+    snapshot.size = image.size();
+    snapshot.format = image.format();
+    snapshot.colorTable = image.colorTable();
+
+    const int bytesPerPixel = image.depth() / 8;
+    const int tilesX = tileCount(image.width());
+    const int tilesY = tileCount(image.height());
+    snapshot.tiles.resize(qsizetype(tilesX) * tilesY);
+    TilePtr *tiles = snapshot.tiles.data();
+
+    const bool comparable = previous && previous->size == snapshot.size
+                            && previous->format == snapshot.format
+                            && previous->colorTable == snapshot.colorTable;
+
+    // 每个行带处理一行块
+    TileScheduler::forEachBand(tilesY, image.bytesPerLine() * TileSize, 0, [&](int begin, int end) {
+        for (int ty = begin; ty < end; ++ty) {
+            const int y0 = ty * TileSize;
+            const int rows = qMin(TileSize, image.height() - y0);
+            for (int tx = 0; tx < tilesX; ++tx) {
+                const int index = ty * tilesX + tx;
+                const qsizetype rowBytes = qsizetype(qMin(TileSize, image.width() - tx * TileSize)) * bytesPerPixel;
+                const qsizetype offset = qsizetype(tx) * TileSize * bytesPerPixel;
+
+                if (comparable) {
+                    const TilePtr &old = previous->tiles[index];
+                    if (!old->compressed) {
+                        const char *oldData = old->data.constData();
+                        bool same = true;
+                        for (int y = 0; y < rows && same; ++y) {
+                            same = std::memcmp(image.constScanLine(y0 + y) + offset,
+                                               oldData + y * rowBytes, rowBytes) == 0;
+                        }
+                        if (same) {
+                            tiles[index] = old;
+                            continue;
+                        }
+                    }
+                }
+
+                TilePtr tile = std::make_shared<Tile>();
+                tile->data.resize(rowBytes * rows);
+                char *data = tile->data.data();
+                for (int y = 0; y < rows; ++y) {
+                    std::memcpy(data + y * rowBytes, image.constScanLine(y0 + y) + offset, rowBytes);
+                }
+                tiles[index] = tile;
+            }
+        }
+    });
+
+    return snapshot;
+}
+
+QImage ImageHistory::toImage(const Snapshot &snapshot)
+{
+    if (!snapshot.live.isNull()) return snapshot.live;
+    if (!snapshot.isStored()) return QImage();
+
+    QImage image(snapshot.size, snapshot.format);
+    if (!snapshot.colorTable.isEmpty()) {
+        image.setColorTable(snapshot.colorTable);
+    }
+
+    const int bytesPerPixel = image.depth() / 8;
+    const int tilesX = tileCount(image.width());
+    const int tilesY = tileCount(image.height());
+    uchar *bits = image.bits();  // 在并行写入前完成分离
+    const qsizetype bytesPerLine = image.bytesPerLine();
+
+    TileScheduler::forEachBand(tilesY, bytesPerLine * TileSize, 0, [&](int begin, int end) {
+        for (int ty = begin; ty < end; ++ty) {
+            const int y0 = ty * TileSize;
+            const int rows = qMin(TileSize, image.height() - y0);
+            for (int tx = 0; tx < tilesX; ++tx) {
+                const Tile &tile = *snapshot.tiles[ty * tilesX + tx];
+                const QByteArray data = tile.compressed ? qUncompress(tile.data) : tile.data;
+                const qsizetype rowBytes = qsizetype(qMin(TileSize, image.width() - tx * TileSize)) * bytesPerPixel;
+                const qsizetype offset = qsizetype(tx) * TileSize * bytesPerPixel;
+                for (int y = 0; y < rows; ++y) {
+                    std::memcpy(bits + (y0 + y) * bytesPerLine + offset,
+                                data.constData() + y * rowBytes, rowBytes);
+                }
+            }
+        }
+    });
+
+    return image;
+}
+
+// 离开当前步时切块：与前一快照（已切块时）比较，相同的块直接共享，之后不再持有完整图像
+void ImageHistory::settle(int index)
+{
+    if (index < 0 || index >= m_snapshots.size() || m_snapshots[index].live.isNull()) return;
+
+    const Snapshot *previous = index > 0 && !m_snapshots[index - 1].tiles.isEmpty() ? &m_snapshots[index - 1]
+                                                                                     : nullptr;
+    const Snapshot tiled = makeSnapshot(m_snapshots[index].live, previous);
+    Snapshot &snapshot = m_snapshots[index];
+    snapshot.size = tiled.size;
+    snapshot.format = tiled.format;
+    snapshot.colorTable = tiled.colorTable;
+    snapshot.tiles = tiled.tiles;
+    snapshot.live = QImage();
+}
+
+// 当前快照及其前后相邻的快照保持未压缩（撤销/重做一步即可直接取用），
+// 最新快照是下一次追加时的比较基准，同样不压缩；其余块压缩保存
+void ImageHistory::compressOlder()
+{
+    QSet<const Tile *> keepRaw;
+    auto keep = [&](int index) {
+        if (!isStored(index)) return;
+        for (const TilePtr &tile : std::as_const(m_snapshots[index].tiles)) {
+            keepRaw.insert(tile.get());
+        }
+    };
+    keep(m_current - 1);
+    keep(m_current);
+    keep(m_current + 1);
+    keep(int(m_snapshots.size()) - 1);
+
+    QSet<const Tile *> seen;
+    std::vector<Tile *> pending;
+    for (const Snapshot &snapshot : std::as_const(m_snapshots)) {
+        for (const TilePtr &tile : snapshot.tiles) {
+            if (tile->compressed || keepRaw.contains(tile.get()) || seen.contains(tile.get())) continue;
+            seen.insert(tile.get());
+            pending.push_back(tile.get());
+        }
+    }
+    if (pending.empty()) return;
+
+    // 块之间互不相关，直接按块并行压缩（快速压缩级别）
+    const qsizetype tileBytes = pending.front()->data.size();
+    TileScheduler::forEachBand(int(pending.size()), tileBytes, 0, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            pending[i]->data = qCompress(pending[i]->data, 1);
+            pending[i]->compressed = true;
+        }
+    });
+}
+
+// 可淘汰的最旧快照：原图和当前快照除外
+int ImageHistory::oldestEvictable() const
+{
+    int oldest = -1;
+    for (int i = 1; i < m_snapshots.size(); ++i) {
+        if (i == m_current || !m_snapshots[i].isStored()) continue;
+        if (oldest < 0 || m_snapshots[i].sequence < m_snapshots[oldest].sequence) {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+// 淘汰快照：只被它引用的块（同一位置的块只在快照之间共享，快照内不重复）和未切块的图像随之释放
+qsizetype ImageHistory::evict(int index)
+{
+    Snapshot &snapshot = m_snapshots[index];
+    qsizetype freed = snapshot.live.sizeInBytes();
+    for (const TilePtr &tile : std::as_const(snapshot.tiles)) {
+        if (tile.use_count() == 1) freed += tile->data.size();
+    }
+    snapshot.tiles.clear();
+    snapshot.live = QImage();
+    return freed;
+}
+
+// 占用量只统计一次，之后每淘汰一个快照减去它释放的字节数（逐次重新统计会随快照数平方增长）
+void ImageHistory::enforceBudgets()
+{
+    // 单文档预算
+    qsizetype bytes = memoryBytes();
+    while (bytes > m_budget) {
+        const int index = oldestEvictable();
+        if (index < 0) break;
+        bytes -= evict(index);
+    }
+
+    // 全局预算：在所有文档中淘汰最旧的快照
+    qsizetype globalBytes = globalMemoryBytes();
+    while (globalBytes > g_globalBudget.load()) {
+        ImageHistory *owner = nullptr;
+        int index = -1;
+        for (ImageHistory *history : std::as_const(registry())) {
+            const int candidate = history->oldestEvictable();
+            if (candidate < 0) continue;
+            if (!owner || history->m_snapshots[candidate].sequence < owner->m_snapshots[index].sequence) {
+                owner = history;
+                index = candidate;
+            }
+        }
+        if (!owner) break;
+        globalBytes -= owner->evict(index);
+    }
+}
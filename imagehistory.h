@@ -0,0 +1,93 @@
+#ifndef IMAGEHISTORY_H
+#define IMAGEHISTORY_H
+
+#include <QImage>
+#include <QList>
+#include <QByteArray>
+#include <memory>
+
+// 撤销历史的分块快照存储
+// 每一步的结果按 TileSize×TileSize 切块保存，与上一步内容相同的块直接共享（写时复制），
+// 只有被命令修改过的块才占用新内存；离当前步较远的块用 qCompress 压缩保存。
+// 新追加（或重新保存）的当前快照直接持有传入的图像，与窗口显示的图像共享缓冲区，离开当前步时才切块，
+// 因此当前步不会同时占用一份完整图像和一份分块副本。
+// 超出单文档或全局内存预算时淘汰最旧的快照，再次需要时由调用者从最近的保留快照重新执行命令得到
+class ImageHistory
+{
+public:
+    static constexpr int TileSize = 256;
+
+    explicit ImageHistory(const QImage &original);
+    ~ImageHistory();
+    Q_DISABLE_COPY(ImageHistory)
+
+    // 快照数：第0个为原图（从不淘汰），第 i 个为执行前 i 个命令后的结果
+    int count() const;
+    // 只保留前 count 个快照（新命令截断重做分支时调用）
+    void truncate(int count);
+    // 追加快照并设为当前快照（持有 image 本身，不复制）
+    void append(const QImage &image);
+    // 设置当前显示的快照：当前快照不会被淘汰，其相邻快照保持未压缩
+    // 该快照已被淘汰时传入重新计算得到的 image，重新保存到历史中
+    void setCurrent(int index, const QImage &image = QImage());
+    // 用内容相同的另一份图像（如转换为规范格式后的）替换当前快照，之后取出的即为该图像
+    void replaceCurrent(const QImage &image);
+    // 第 index 个快照是否仍保存在历史中（未被淘汰）
+    bool isStored(int index) const;
+    // 快照编号：在整个程序中唯一，快照被淘汰后不变（用作结果缓存的输入标识）
+    quint64 snapshotId(int index) const;
+    // 取出第 index 个快照，已被淘汰时返回空图像
+    QImage image(int index) const;
+    // 第 index 个快照之前（含）最近的保留快照；原图从不淘汰，因此总能找到
+    // 由它起依次执行第 base..index-1 个命令即得到第 index 个快照
+    int storedBase(int index) const;
+
+    // 当前占用的内存（共享块只计一次）
+    qsizetype memoryBytes() const;
+
+    // 单文档内存预算（默认 1 GB）；setDefaultBudget 影响之后创建的历史记录
+    void setBudget(qsizetype bytes);
+    qsizetype budget() const;
+    static void setDefaultBudget(qsizetype bytes);
+    static qsizetype defaultBudget();
+    // 所有文档合计的内存预算（默认 4 GB）
+    static void setGlobalBudget(qsizetype bytes);
+    static qsizetype globalBudget();
+    static qsizetype globalMemoryBytes();
+    // 环境变量 PSVIDIO_HISTORY_BUDGET_MB / PSVIDIO_HISTORY_GLOBAL_BUDGET_MB 设置单文档 / 全局预算（MB）
+    static void initFromEnvironment();
+
+private:
+    struct Tile
+    {
+        QByteArray data;          // 块内各行连续存放；压缩后为 qCompress 的结果
+        bool compressed = false;
+    };
+    using TilePtr = std::shared_ptr<Tile>;
+
+    struct Snapshot
+    {
+        QSize size;
+        QImage::Format format = QImage::Format_Invalid;
+        QList<QRgb> colorTable;
+        QList<TilePtr> tiles;     // 与 live 都为空表示已被淘汰
+        QImage live;              // 尚未切块的当前快照（与调用者共享缓冲区）
+        quint64 sequence = 0;     // 创建顺序，淘汰时先淘汰最旧的
+        bool isStored() const { return !tiles.isEmpty() || !live.isNull(); }
+    };
+
+    static Snapshot makeSnapshot(const QImage &image, const Snapshot *previous);
+    static QImage toImage(const Snapshot &snapshot);
+
+    void settle(int index);     // 未切块的快照切块保存（与前一快照共享相同的块）
+    void compressOlder();       // 压缩远离当前快照的块
+    int oldestEvictable() const;
+    qsizetype evict(int index);  // 返回释放的字节数
+    void enforceBudgets();
+
+    QList<Snapshot> m_snapshots;
+    int m_current = 0;
+    qsizetype m_budget;
+};
+
+#endif // IMAGEHISTORY_H
@@ -0,0 +1,75 @@
+#include "imageloader.h"
+#include "mappedimageio.h"
+#include "pixelview.h"
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QThreadPool>
+#include <QThread>
+#include <QFileInfo>
+
+namespace {
+
+// 分配上限是全局设置，只在第一次解码前设置一次
+void raiseAllocationLimit()
+{
+    static const bool raised = [] {
+        QImageReader::setAllocationLimit(qMax(QImageReader::allocationLimit(),
+                                              ImageLoader::AllocationLimitMB));
+        return true;
+    }();
+    Q_UNUSED(raised);
+}
+
+} // namespace
+
+namespace ImageLoader {
+
+Preview readPreview(const QString &filePath, const QSize &bound)
+{
+    raiseAllocationLimit();
+
+    Preview preview;
+    // 映射读取的格式整张打开几乎没有解码开销，只取尺寸占位
+    if (MappedImageIO::supportsSuffix(QFileInfo(filePath).suffix())) {
+        preview.imageSize = MappedImageIO::readSize(filePath);
+        return preview;
+    }
+
+    QImageReader reader(filePath);
+    preview.imageSize = reader.size();
+    if (!preview.imageSize.isValid()) return preview;
+
+    const bool larger = preview.imageSize.width() > bound.width()
+                        || preview.imageSize.height() > bound.height();
+    if (larger && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+        reader.setScaledSize(preview.imageSize.scaled(bound, Qt::KeepAspectRatio));
+        preview.image = reader.read();
+    }
+    return preview;
+}
+
+QImage readImage(const QString &filePath)
+{
+    if (MappedImageIO::supportsSuffix(QFileInfo(filePath).suffix())) {
+        // 零拷贝映射的图片保持原格式（如 PPM 的 RGB888、4通道 PAM 的 RGBA8888），不在加载时整图复制：
+        // 显示直接支持这些格式；首次执行命令时由窗口转换一次为规范格式并保存在历史中（见 FileViewSubWindow::commandInput）
+        return MappedImageIO::read(filePath);
+    }
+
+    raiseAllocationLimit();
+
+    QImageReader reader(filePath);
+    return PixelView::toCanonical(reader.read());
+}
+
+QThreadPool *decodePool()
+{
+    static QThreadPool *pool = [] {
+        QThreadPool *p = new QThreadPool;
+        p->setMaxThreadCount(qBound(1, QThread::idealThreadCount(), MaxDecodeThreads));
+        return p;
+    }();
+    return pool;
+}
+
+} // namespace ImageLoader
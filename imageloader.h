@@ -0,0 +1,35 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+class QThreadPool;
+
+// 图片解码（可在任意线程调用）
+namespace ImageLoader {
+
+struct Preview
+{
+    QSize imageSize;  // 原图尺寸（只读文件头即可得到）
+    QImage image;     // 缩小解码的预览；解码器不支持缩放解码或原图不大于 bound 时为空
+};
+
+// 读取原图尺寸，并在解码器支持 ScaledSize 时直接按 bound 缩小解码（如 JPEG 的 DCT 缩放），
+// 代价远小于完整解码
+Preview readPreview(const QString &filePath, const QSize &bound);
+
+// 完整解码并转换为规范处理格式（见 PixelView::toCanonical）；分配上限提高到 AllocationLimitMB，避免大图被 Qt 默认的 256 MB 上限拒绝
+// 例外：内存映射读取（见 MappedImageIO）的图片保持原格式（零拷贝），首次执行命令时才转换一次
+constexpr int AllocationLimitMB = 8192;
+QImage readImage(const QString &filePath);
+
+// 解码专用线程池：同时进行的解码数不超过 MaxDecodeThreads，
+// 同时打开大量文件时排队的任务尚未分配像素内存，峰值内存因此受控
+constexpr int MaxDecodeThreads = 4;
+QThreadPool *decodePool();
+
+} // namespace ImageLoader
+
+#endif // IMAGELOADER_H
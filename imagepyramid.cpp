@@ -0,0 +1,111 @@
+#include "imagepyramid.h"
+#include "tilescheduler.h"
+
+namespace {
+
+// 按字节逐通道求均值的格式；带透明通道时用预乘格式，保证均值混合正确
+QImage toHalvingFormat(const QImage &image)
+{
+    switch (image.format()) {
+    case QImage::Format_Grayscale8:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB888:
+        return image;
+    default:
+        return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                             : QImage::Format_RGB32);
+    }
+}
+
+} // namespace
+
+ImagePyramid::ImagePyramid(const QImage &image)
+    : m_sourceKey(image.cacheKey())
+{
+    if (image.isNull()) return;
+
+    m_levels.append(image);
+    QImage level = image;
+    while (qMax(level.width(), level.height()) > MinSide) {
+        level = halve(level);
+        m_levels.append(level);
+    }
+}
+
+bool ImagePyramid::isNull() const
+{
+    return m_levels.isEmpty();
+}
+
+qint64 ImagePyramid::sourceKey() const
+{
+    return m_sourceKey;
+}
+
+int ImagePyramid::levelCount() const
+{
+    return m_levels.size();
+}
+
+QImage ImagePyramid::level(int index) const
+{
+    return m_levels.value(index);
+}
+
+QImage ImagePyramid::levelFor(const QSize &size) const
+{
+    for (int i = m_levels.size() - 1; i > 0; --i) {
+        const QImage &level = m_levels[i];
+        if (level.width() >= size.width() && level.height() >= size.height()) {
+            return level;
+        }
+    }
+    return m_levels.value(0);
+}
+
+QImage ImagePyramid::halve(const QImage &image)
+{
+    const QImage source = toHalvingFormat(image);
+    const int width = source.width();
+    const int height = source.height();
+    const int halfWidth = (width + 1) / 2;
+    const int halfHeight = (height + 1) / 2;
+    QImage resultImage(halfWidth, halfHeight, source.format());
+
+    // 各通道均为一个字节，32位格式的 B/G/R/A 与8位、24位格式统一按字节求均值
+    const int channels = source.depth() / 8;
+    const uchar *srcBits = source.constBits();
+    const qsizetype srcStride = source.bytesPerLine();
+    uchar *dstBits = resultImage.bits();
+    const qsizetype dstStride = resultImage.bytesPerLine();
+
+    TileScheduler::forEachBand(halfHeight, srcStride * 2, 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const uchar *row0 = srcBits + qsizetype(2 * y) * srcStride;
+            const uchar *row1 = srcBits + qsizetype(qMin(2 * y + 1, height - 1)) * srcStride;
+            uchar *out = dstBits + qsizetype(y) * dstStride;
+
+            // 成对的列：直接相邻取 2×2
+            const int pairs = width / 2;
+            const int pairBytes = pairs * channels;
+            for (int x = 0; x < pairs; ++x) {
+                const uchar *a = row0 + 2 * x * channels;
+                const uchar *b = row1 + 2 * x * channels;
+                uchar *o = out + x * channels;
+                for (int c = 0; c < channels; ++c) {
+                    o[c] = uchar((a[c] + a[c + channels] + b[c] + b[c + channels] + 2) >> 2);
+                }
+            }
+            // 奇数宽度的最后一列只有一列可取
+            if (width & 1) {
+                const int x = (width - 1) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    out[pairBytes + c] = uchar((row0[x + c] + row1[x + c] + 1) >> 1);
+                }
+            }
+        }
+    });
+
+    return resultImage;
+}
@@ -0,0 +1,35 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QImage>
+#include <QList>
+#include <QSize>
+
+// 显示用多级缩略图（mipmap）：第0级为原图，之后每级宽高减半（2×2均值），直到最长边不超过 MinSide
+// 缩放显示时从不小于目标尺寸的最小层级重采样，代价与屏幕像素数相当而与原图大小无关
+class ImagePyramid
+{
+public:
+    static constexpr int MinSide = 128;
+
+    ImagePyramid() = default;
+    explicit ImagePyramid(const QImage &image);
+
+    bool isNull() const;
+    // 构建所用图像的 cacheKey，图像变化后据此判断金字塔已过期
+    qint64 sourceKey() const;
+
+    int levelCount() const;
+    QImage level(int index) const;
+    // 宽高均不小于 size 的最小层级（目标比原图大时返回原图）
+    QImage levelFor(const QSize &size) const;
+
+    // 宽高各缩小一半（奇数向上取整），每个目标像素为对应 2×2 源像素的均值
+    static QImage halve(const QImage &image);
+
+private:
+    QList<QImage> m_levels;
+    qint64 m_sourceKey = 0;
+};
+
+#endif // IMAGEPYRAMID_H
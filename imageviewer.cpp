@@ -0,0 +1,280 @@
+#include "imageviewer.h"
+#include "perftrace.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QLoggingCategory>
+#include <cmath>
+
+// 缩放帧耗时分布，默认关闭；QT_LOGGING_RULES="psvidio.viewer.debug=true" 时输出
+Q_LOGGING_CATEGORY(lcViewer, "psvidio.viewer", QtWarningMsg)
+
+ImageViewer::ImageViewer(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFrameShape(QFrame::NoFrame);
+    viewport()->setCursor(Qt::OpenHandCursor);
+
+    m_refineTimer = new QTimer(this);
+    m_refineTimer->setInterval(RefineDelay);
+    m_refineTimer->setSingleShot(true);
+    connect(m_refineTimer, &QTimer::timeout, this, &ImageViewer::refine);
+}
+
+void ImageViewer::setImage(const QImage &image, const ImagePyramid &pyramid)
+{
+    m_image = image;
+    m_imageSize = image.size();
+    m_pyramid = pyramid.sourceKey() == image.cacheKey() ? pyramid : ImagePyramid();
+    m_preview = QImage();
+    clearTiles();
+    updateScrollBars();
+    viewport()->update();
+}
+
+void ImageViewer::setPyramid(const ImagePyramid &pyramid)
+{
+    if (pyramid.sourceKey() != m_image.cacheKey()) return;
+    m_pyramid = pyramid;
+    if (m_preview.isNull()) {
+        clearTiles();
+        viewport()->update();
+    }
+}
+
+void ImageViewer::setPreview(const QImage &preview)
+{
+    m_preview = preview;
+    clearTiles();
+    viewport()->update();
+}
+
+void ImageViewer::setPlaceholder(const QImage &preview, const QSize &imageSize)
+{
+    m_image = QImage();
+    m_imageSize = imageSize;
+    m_pyramid = ImagePyramid();
+    m_preview = preview;
+    clearTiles();
+    updateScrollBars();
+    viewport()->update();
+}
+
+void ImageViewer::setScale(qreal scale, bool interactive)
+{
+    scale = qMax<qreal>(0.001, scale);
+    if (qFuzzyCompare(scale, m_scale)) return;
+
+    // 连续缩放中每次都重新计时，输入停止后才精细重绘
+    if (interactive) {
+        m_fastRender = true;
+        m_refineTimer->start();
+    }
+
+    // 记录视口中心对应的图片坐标
+    const QPoint origin = contentOrigin();
+    const QPointF center = (QPointF(viewport()->width(), viewport()->height()) / 2.0 - origin) / m_scale;
+
+    m_scale = scale;
+    clearTiles();
+    updateScrollBars();
+
+    horizontalScrollBar()->setValue(qRound(center.x() * m_scale - viewport()->width() / 2.0));
+    verticalScrollBar()->setValue(qRound(center.y() * m_scale - viewport()->height() / 2.0));
+    viewport()->update();
+}
+
+qreal ImageViewer::scale() const
+{
+    return m_scale;
+}
+
+QSize ImageViewer::contentSize() const
+{
+    return QSize(qMax(1, qRound(m_imageSize.width() * m_scale)), qMax(1, qRound(m_imageSize.height() * m_scale)));
+}
+
+QSize ImageViewer::canvasSize(qreal dpr) const
+{
+    return QSize(qMax(1, qRound(m_imageSize.width() * m_scale * dpr)),
+                 qMax(1, qRound(m_imageSize.height() * m_scale * dpr)));
+}
+
+// 内容比视口小时居中，否则由滚动条决定偏移
+QPoint ImageViewer::contentOrigin() const
+{
+    const QSize content = contentSize();
+    const int x = content.width() < viewport()->width() ? (viewport()->width() - content.width()) / 2
+                                                         : -horizontalScrollBar()->value();
+    const int y = content.height() < viewport()->height() ? (viewport()->height() - content.height()) / 2
+                                                           : -verticalScrollBar()->value();
+    return QPoint(x, y);
+}
+
+// 预览优先；金字塔就绪时取不小于画布尺寸的最小层级
+QImage ImageViewer::sourceFor(const QSize &canvas) const
+{
+    if (!m_preview.isNull()) return m_preview;
+    if (!m_pyramid.isNull()) return m_pyramid.levelFor(canvas);
+    return m_image;
+}
+
+// 渲染一个设备像素块：只复制源图中对应的小块（外扩1像素保证平滑采样在块边界连续）再缩放
+// 快速模式用最近邻采样，代价只与块的像素数有关
+QPixmap ImageViewer::renderTile(int tx, int ty, const QSize &canvas, bool smooth) const
+{
+    PERF_TRACE("ImageViewer::renderTile");
+    const QRect tileRect = QRect(tx * TileSize, ty * TileSize, TileSize, TileSize)
+                               .intersected(QRect(QPoint(0, 0), canvas));
+    const QImage source = sourceFor(canvas);
+
+    const qreal fx = source.width() / qreal(canvas.width());
+    const qreal fy = source.height() / qreal(canvas.height());
+    const QRectF sourceRect(tileRect.x() * fx, tileRect.y() * fy,
+                            tileRect.width() * fx, tileRect.height() * fy);
+    const QRect copyRect = sourceRect.toAlignedRect().adjusted(-1, -1, 1, 1).intersected(source.rect());
+    const QImage part = source.copy(copyRect);
+
+    QImage tile(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+    tile.fill(Qt::transparent);
+    QPainter painter(&tile);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+    painter.drawImage(QRectF(QPointF(0, 0), QSizeF(tileRect.size())), part,
+                      sourceRect.translated(-copyRect.topLeft()));
+    painter.end();
+
+    return QPixmap::fromImage(tile);
+}
+
+void ImageViewer::paintEvent(QPaintEvent *event)
+{
+    PERF_TRACE("ImageViewer::paintEvent");
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().window());
+    if (m_imageSize.isEmpty() || (m_image.isNull() && m_preview.isNull())) return;
+
+    const qreal dpr = viewport()->devicePixelRatioF();
+    if (dpr != m_tileDpr) {
+        clearTiles();
+        m_tileDpr = dpr;
+    }
+
+    // 可见区域换算到设备像素画布坐标，只绘制与之相交的块
+    const QSize canvas = canvasSize(dpr);
+    const QPoint origin = contentOrigin();
+    const QRectF visible = QRectF(event->rect().translated(-origin)).intersected(
+        QRectF(QPointF(0, 0), QSizeF(contentSize())));
+    if (visible.isEmpty()) return;
+
+    const int tileX0 = qMax(0, int(std::floor(visible.left() * dpr / TileSize)));
+    const int tileY0 = qMax(0, int(std::floor(visible.top() * dpr / TileSize)));
+    const int tileX1 = qMin((canvas.width() - 1) / TileSize, int(std::floor(visible.right() * dpr / TileSize)));
+    const int tileY1 = qMin((canvas.height() - 1) / TileSize, int(std::floor(visible.bottom() * dpr / TileSize)));
+
+    for (int ty = tileY0; ty <= tileY1; ++ty) {
+        for (int tx = tileX0; tx <= tileX1; ++tx) {
+            const quint64 key = (quint64(ty) << 32) | quint32(tx);
+            QPixmap *tile = m_tiles.object(key);
+            if (!tile) {
+                tile = new QPixmap(renderTile(tx, ty, canvas, !m_fastRender));
+                tile->setDevicePixelRatio(dpr);
+                m_tiles.insert(key, tile);
+                tile = m_tiles.object(key);
+                if (!tile) continue;
+            }
+            painter.drawPixmap(QPointF(origin) + QPointF(tx, ty) * (TileSize / dpr), *tile);
+        }
+    }
+
+    if (m_fastRender) {
+        const qint64 ms = frameTimer.elapsed();
+        const int bucket = ms < 4 ? 0 : ms < 8 ? 1 : ms < 16 ? 2 : ms < 33 ? 3 : ms < 66 ? 4 : 5;
+        ++m_frameHistogram[bucket];
+    }
+}
+
+void ImageViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+// 滚轮用于缩放，交给子窗口处理
+void ImageViewer::wheelEvent(QWheelEvent *event)
+{
+    event->ignore();
+}
+
+void ImageViewer::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    m_panning = true;
+    m_panStart = event->position().toPoint();
+    viewport()->setCursor(Qt::ClosedHandCursor);
+}
+
+void ImageViewer::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_panning) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+    const QPoint delta = event->position().toPoint() - m_panStart;
+    m_panStart = event->position().toPoint();
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+}
+
+void ImageViewer::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_panning) {
+        m_panning = false;
+        viewport()->setCursor(Qt::OpenHandCursor);
+        return;
+    }
+    QAbstractScrollArea::mouseReleaseEvent(event);
+}
+
+void ImageViewer::updateScrollBars()
+{
+    const QSize content = contentSize();
+    const QSize view = viewport()->size();
+    horizontalScrollBar()->setRange(0, qMax(0, content.width() - view.width()));
+    horizontalScrollBar()->setPageStep(view.width());
+    verticalScrollBar()->setRange(0, qMax(0, content.height() - view.height()));
+    verticalScrollBar()->setPageStep(view.height());
+
+    // 缓存容量：约两屏的块数
+    const qreal dpr = qMax<qreal>(1.0, viewport()->devicePixelRatioF());
+    const int tilesX = int(std::ceil(view.width() * dpr / TileSize)) + 1;
+    const int tilesY = int(std::ceil(view.height() * dpr / TileSize)) + 1;
+    m_tiles.setMaxCost(qMax(16, 2 * tilesX * tilesY));
+}
+
+void ImageViewer::refine()
+{
+    if (!m_fastRender) return;
+    m_fastRender = false;
+
+    const std::array<int, 6> &h = m_frameHistogram;
+    qCDebug(lcViewer).noquote() << QString("缩放帧耗时分布（%1x%2）：<4ms %3，<8ms %4，<16ms %5，<33ms %6，<66ms %7，>=66ms %8")
+                                       .arg(m_imageSize.width()).arg(m_imageSize.height())
+                                       .arg(h[0]).arg(h[1]).arg(h[2]).arg(h[3]).arg(h[4]).arg(h[5]);
+    m_frameHistogram.fill(0);
+
+    clearTiles();
+    viewport()->update();
+}
+
+void ImageViewer::clearTiles()
+{
+    m_tiles.clear();
+}
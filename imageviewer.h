@@ -0,0 +1,80 @@
+#ifndef IMAGEVIEWER_H
+#define IMAGEVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QPoint>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <array>
+#include "imagepyramid.h"
+
+// 按视口分块绘制的图片查看控件（替代 QScrollArea 中放整张缩放 QPixmap 的 QLabel）
+// 只渲染可见区域的 TileSize×TileSize 设备像素块，块从金字塔中最接近的层级重采样并按 LRU 缓存，
+// 内存占用只与视口大小有关，与图片尺寸和缩放比例无关；支持鼠标拖动平移和高DPI屏幕
+// 滚轮事件不处理，交由所在子窗口实现缩放
+// 连续缩放时先用最近邻快速绘制，输入停止 RefineDelay 毫秒后再高质量重绘一次
+class ImageViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int TileSize = 256;
+    static constexpr int RefineDelay = 150;
+
+    explicit ImageViewer(QWidget *parent = nullptr);
+
+    // 设置显示的图片；pyramid 与图片匹配时从其层级取样
+    void setImage(const QImage &image, const ImagePyramid &pyramid = ImagePyramid());
+    // 图片的金字塔构建完成后补充设置（与当前图片不匹配时忽略）
+    void setPyramid(const ImagePyramid &pyramid);
+    // 临时显示预览图：按当前图片的尺寸拉伸显示，setImage 时清除
+    void setPreview(const QImage &preview);
+    // 图片解码完成前的占位：preview 按 imageSize 拉伸显示（可为空，只占位）
+    void setPlaceholder(const QImage &preview, const QSize &imageSize);
+
+    // 缩放比例（1.0 为 100%），缩放时保持视口中心对应的图片位置不变
+    // interactive 为 true 表示连续缩放中：快速绘制，停止后再精细重绘
+    void setScale(qreal scale, bool interactive = false);
+    qreal scale() const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    QSize contentSize() const;                  // 缩放后的逻辑尺寸
+    QSize canvasSize(qreal dpr) const;          // 缩放后的设备像素尺寸
+    QPoint contentOrigin() const;               // 内容左上角在视口中的位置
+    QImage sourceFor(const QSize &canvas) const;
+    QPixmap renderTile(int tx, int ty, const QSize &canvas, bool smooth) const;
+    void updateScrollBars();
+    void clearTiles();
+    void refine();              // 连续缩放结束：高质量重绘并输出帧耗时分布
+
+    QImage m_image;
+    QSize m_imageSize;                  // 显示的逻辑尺寸（占位时为原图尺寸）
+    ImagePyramid m_pyramid;
+    QImage m_preview;
+    qreal m_scale = 1.0;
+
+    QCache<quint64, QPixmap> m_tiles;   // 设备像素块缓存，代价以块数计
+    qreal m_tileDpr = 0;                // 缓存块对应的设备像素比
+
+    bool m_panning = false;
+    QPoint m_panStart;
+
+    // 两阶段绘制
+    bool m_fastRender = false;          // 连续缩放中，块用最近邻采样
+    QTimer *m_refineTimer = nullptr;
+    // 连续缩放期间每帧绘制耗时的分布：<4、<8、<16、<33、<66、≥66 毫秒
+    std::array<int, 6> m_frameHistogram {};
+};
+
+#endif // IMAGEVIEWER_H
@@ -1,15 +1,33 @@
 #include "mainwindow.h"
+#include "batchprocessor.h"
+#include "imagehistory.h"
+#include "perftrace.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // 批处理模式：不创建窗口，可在无显示器的机器上运行
+    if (argc > 1 && std::strcmp(argv[1], "--batch") == 0) {
+        QCoreApplication a(argc, argv);
+        PerfTrace::initFromEnvironment();
+        const int code = BatchProcessor::run(a.arguments().mid(2));
+        PerfTrace::writeEnvironmentTrace();
+        return code;
+    }
+
     // 关键：启用Qt6高DPI缩放（必须在QApplication创建前）
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     QApplication a(argc, argv);
+    PerfTrace::initFromEnvironment();
+    ImageHistory::initFromEnvironment();
 
     MainWindow w;
     w.show();
-    return a.exec();
+    const int code = a.exec();
+    PerfTrace::writeEnvironmentTrace();
+    return code;
 }
@@ -6,10 +6,32 @@
 #include "meanfiltercommand.h"
 #include "gammacorrectioncommand.h"
 #include "edgedetectioncommand.h"
+#include "mappedimageio.h"
+#include "perftrace.h"
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QToolBar>
 #include <QLabel>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QStatusBar>
+#include <QSignalBlocker>
+#include <memory>
+
+namespace {
+
+// 一次打开操作中的多个文件：统计首个标签出现和全部加载完成的耗时
+struct OpenBatch
+{
+    QElapsedTimer timer;
+    int total = 0;
+    int remaining = 0;
+    qint64 firstTabMs = -1;
+    QPointer<QMdiSubWindow> firstWindow;
+};
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -17,6 +39,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_binaryThreshold(128)
     , m_gammaValue(1.0)
     , m_edgeThreshold(50)
+    , m_meanRadius(1)
 {
     ui->setupUi(this);
 
@@ -65,6 +88,9 @@ MainWindow::MainWindow(QWidget *parent)
             if (imageWin) {
                 // 连接命令应用信号
                 connect(imageWin, &FileViewSubWindow::commandApplied, this, &MainWindow::onCommandApplied);
+                // 完整图片解码完成后启用命令
+                connect(imageWin, &FileViewSubWindow::imageReady, this, &MainWindow::onImageReady,
+                        Qt::UniqueConnection);
                 // 初始化当前命令
                 onCommandApplied(imageWin->getCurrentCommand());
             }
@@ -129,6 +155,23 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_edgeThresholdSlider, &QSlider::sliderPressed, this, &MainWindow::on_sliderPressed);
     connect(m_edgeThresholdSlider, &QSlider::sliderReleased, this, &MainWindow::on_edgeThresholdSlider_released);
     
+    // 创建均值滤波半径控件
+    meanLabel = new QLabel("滤波半径：", this);
+    m_meanRadiusSlider = new QSlider(Qt::Horizontal, this);
+    m_meanRadiusSlider->setRange(1, 50); // 半径1-50，对应3×3到101×101窗口
+    m_meanRadiusSlider->setValue(m_meanRadius);
+    m_meanRadiusSlider->setToolTip("均值滤波半径 (1-50)");
+    m_meanRadiusSlider->setMinimumWidth(150); // 设置最小宽度
+    m_meanRadiusSlider->setMaximumWidth(200); // 设置最大宽度
+    m_meanRadiusSlider->setFixedHeight(20); // 设置固定高度
+    m_meanRadiusSlider->setEnabled(false); // 默认不可用
+    meanValueLabel = new QLabel(QString::number(m_meanRadius), this);
+    meanValueLabel->setFixedWidth(40); // 固定宽度以对齐
+    meanValueLabel->setAlignment(Qt::AlignCenter);
+    connect(m_meanRadiusSlider, &QSlider::valueChanged, this, &MainWindow::on_meanRadiusSlider_valueChanged);
+    connect(m_meanRadiusSlider, &QSlider::sliderPressed, this, &MainWindow::on_sliderPressed);
+    connect(m_meanRadiusSlider, &QSlider::sliderReleased, this, &MainWindow::on_meanRadiusSlider_released);
+    
     // 将控件添加到工具栏
     toolBar->addWidget(binaryLabel);
     toolBar->addWidget(m_binaryThresholdSlider);
@@ -139,6 +182,9 @@ MainWindow::MainWindow(QWidget *parent)
     toolBar->addWidget(edgeLabel);
     toolBar->addWidget(m_edgeThresholdSlider);
     toolBar->addWidget(edgeValueLabel);
+    toolBar->addWidget(meanLabel);
+    toolBar->addWidget(m_meanRadiusSlider);
+    toolBar->addWidget(meanValueLabel);
     
     // 默认隐藏所有标签、滑块和数值显示
     binaryLabel->setVisible(false);
@@ -150,9 +196,21 @@ MainWindow::MainWindow(QWidget *parent)
     edgeLabel->setVisible(false);
     m_edgeThresholdSlider->setVisible(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    meanValueLabel->setVisible(false);
     
     // 确保工具栏在所有其他控件之上
     toolBar->raise();
+
+    // 没有已解码的图片时禁用图像处理命令
+    updateCommandActions();
+
+    // 由 PSVIDIO_TRACE 环境变量开启跟踪时同步菜单状态
+    {
+        const QSignalBlocker blocker(ui->actionTrace);
+        ui->actionTrace->setChecked(PerfTrace::isEnabled());
+    }
 }
 
 MainWindow::~MainWindow()
@@ -182,7 +240,7 @@ void MainWindow::on_actionOpen_O_triggered()
         this,
         tr("选择媒体文件"),          // 对话框标题（国际化）
         QDir::homePath(),           // 默认路径（用户主目录）
-        tr("媒体文件 (*.jpg *.jpeg *.png *.bmp *.mp4 *.avi *.mov);;所有文件 (*.*)")  // 过滤规则
+        tr("媒体文件 (*.jpg *.jpeg *.png *.bmp *.ppm *.pgm *.pam *.praw *.mp4 *.avi *.mov);;所有文件 (*.*)")  // 过滤规则
         );
 
     // 无文件选择时直接返回
@@ -190,17 +248,161 @@ void MainWindow::on_actionOpen_O_triggered()
         return;
     }
 
-    // 为每个文件创建MDI子窗口
+    std::shared_ptr<OpenBatch> batch = std::make_shared<OpenBatch>();
+    batch->timer.start();
+    batch->total = filePaths.size();
+    batch->remaining = filePaths.size();
+
+    // 有可显示内容时再加入标签页
+    auto addTab = [this, batch](FileViewSubWindow *subWindow) {
+        ui->mdiArea->addSubWindow(subWindow);
+        subWindow->showMaximized();  // 默认为最大化状态
+
+        if (batch->firstTabMs < 0) {
+            batch->firstTabMs = batch->timer.elapsed();
+            batch->firstWindow = subWindow;
+            statusBar()->showMessage(tr("首个标签：%1 ms").arg(batch->firstTabMs));
+        } else if (batch->firstWindow) {
+            // 保持第一个打开的窗口处于激活状态
+            ui->mdiArea->setActiveSubWindow(batch->firstWindow);
+        }
+    };
+    auto finishOne = [this, batch]() {
+        if (--batch->remaining > 0) return;
+        statusBar()->showMessage(tr("已打开 %1 个文件：首个标签 %2 ms，全部加载 %3 ms")
+                                     .arg(batch->total).arg(batch->firstTabMs).arg(batch->timer.elapsed()));
+    };
+
+    // 为每个文件创建MDI子窗口：图片在解码线程池中并行解码（同时进行的解码数有上限），
+    // 各子窗口在预览解码完成后按完成顺序加入标签页
     for (const QString &filePath : filePaths) {
         FileViewSubWindow *subWindow = new FileViewSubWindow(filePath, this);
         subWindow->setAttribute(Qt::WA_DeleteOnClose);
-        ui->mdiArea->addSubWindow(subWindow);
-        subWindow->showMaximized();  // 默认为最大化状态
+        connect(subWindow, &FileViewSubWindow::operationTimed, this, &MainWindow::showOperationTime);
+
+        if (subWindow->hasPreview()) {
+            addTab(subWindow);
+            finishOne();
+            continue;
+        }
+        connect(subWindow, &FileViewSubWindow::previewReady, this, [=]() { addTab(subWindow); });
+        // 加载完成前关闭的标签同样计为完成；destroyed 排队处理，主窗口析构时不再执行
+        std::shared_ptr<bool> counted = std::make_shared<bool>(false);
+        auto finishWindow = [finishOne, counted]() {
+            if (*counted) return;
+            *counted = true;
+            finishOne();
+        };
+        connect(subWindow, &FileViewSubWindow::loadFinished, this, finishWindow);
+        connect(subWindow, &QObject::destroyed, this, finishWindow, Qt::QueuedConnection);
+    }
+}
+
+
+// 保存当前图片：PNM/PAM/.praw 通过内存映射直接写入，其余格式交给 QImage::save
+void MainWindow::on_actionSave_S_triggered()
+{
+    FileViewSubWindow *imageWin = currentImageSubWindow();
+    if (!imageWin || !imageWin->isImageReady()) return;
+
+    const QString filePath = QFileDialog::getSaveFileName(
+        this,
+        tr("保存图片"),
+        QDir::homePath(),
+        tr("PNG (*.png);;JPEG (*.jpg *.jpeg);;BMP (*.bmp);;PPM (*.ppm);;PGM (*.pgm);;PAM (*.pam);;原始数据 (*.praw)")
+        );
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage image = imageWin->getCurrentImage();
+    QString error;
+    bool ok;
+    if (MappedImageIO::supportsSuffix(QFileInfo(filePath).suffix())) {
+        ok = MappedImageIO::write(image, filePath, &error);
+    } else {
+        ok = image.save(filePath);
+    }
+
+    if (ok) {
+        statusBar()->showMessage(tr("已保存 %1：%2 ms").arg(QFileInfo(filePath).fileName()).arg(timer.elapsed()));
+    } else {
+        statusBar()->showMessage(tr("保存失败：%1").arg(error.isEmpty() ? filePath : error));
+    }
+}
+
+
+// 导出处理后的视频：进度和帧率显示在状态栏，导出期间该窗口的处理命令不可用
+void MainWindow::on_actionExportVideo_triggered()
+{
+    FileViewSubWindow *videoWin = currentImageSubWindow();
+    if (!videoWin || !videoWin->canExportVideo()) return;
+
+    const QString filePath = QFileDialog::getSaveFileName(
+        this,
+        tr("导出视频"),
+        QDir::homePath(),
+        tr("MP4 (*.mp4);;QuickTime (*.mov);;Matroska (*.mkv);;AVI (*.avi)")
+        );
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    VideoExporter *exporter = videoWin->exportVideo(filePath);
+    if (!exporter) return;
+    connect(exporter, &VideoExporter::progressChanged, this,
+            [this, exporter](qint64 frames, qint64 position, qint64 duration) {
+                statusBar()->showMessage(tr("导出中：%1 帧，%2 / %3 s，%4 帧/s")
+                                             .arg(frames)
+                                             .arg(position / 1000.0, 0, 'f', 1)
+                                             .arg(duration / 1000.0, 0, 'f', 1)
+                                             .arg(exporter->framesPerSecond(), 0, 'f', 1));
+            });
+    // 排队执行：窗口关闭时导出器在窗口析构过程中发出 finished，待窗口删除后再刷新菜单状态
+    connect(exporter, &VideoExporter::finished, this, [this](bool ok, const QString &message) {
+        statusBar()->showMessage(ok ? message : tr("导出失败：%1").arg(message));
+        updateCommandActions();
+    }, Qt::QueuedConnection);
+    updateCommandActions();
+}
+
+
+// 最近一次操作的耗时和吞吐量
+void MainWindow::showOperationTime(const QString &name, qint64 nsecs, double megapixels)
+{
+    const double ms = nsecs / 1e6;
+    QString message = tr("%1：%2 ms").arg(name).arg(ms, 0, 'f', 1);
+    if (megapixels > 0 && nsecs > 0) {
+        message += tr("，%1 MP/s").arg(megapixels / (nsecs / 1e9), 0, 'f', 1);
+    }
+    statusBar()->showMessage(message);
+}
+
+void MainWindow::on_actionTrace_toggled(bool checked)
+{
+    PerfTrace::setEnabled(checked);
+    statusBar()->showMessage(checked ? tr("性能跟踪已开启") : tr("性能跟踪已关闭"));
+}
+
+void MainWindow::on_actionExportTrace_triggered()
+{
+    const QString filePath = QFileDialog::getSaveFileName(
+        this,
+        tr("导出性能跟踪"),
+        QDir::homePath() + "/psvidio-trace.json",
+        tr("Chrome 跟踪文件 (*.json)")
+        );
+    if (filePath.isEmpty()) {
+        return;
     }
 
-    // 激活第一个打开的窗口（Qt6 QMdiArea 子窗口列表）
-    if (!ui->mdiArea->subWindowList().isEmpty()) {
-        ui->mdiArea->setActiveSubWindow(ui->mdiArea->subWindowList().first());
+    QString error;
+    if (PerfTrace::writeChromeTrace(filePath, &error)) {
+        statusBar()->showMessage(tr("已导出 %1 个跟踪事件：%2").arg(PerfTrace::events().size()).arg(filePath));
+    } else {
+        statusBar()->showMessage(tr("导出失败：%1").arg(error));
     }
 }
 
@@ -225,6 +427,7 @@ void MainWindow::on_mdiArea_subWindowActivated(QMdiSubWindow *arg1)
         // 无图片窗口时禁用Slider
         ui->horizontalSliderScale->setEnabled(false);
         ui->labelScale->setText(tr("当前缩放：--"));
+        updateCommandActions();
         return;
     }
 
@@ -233,6 +436,27 @@ void MainWindow::on_mdiArea_subWindowActivated(QMdiSubWindow *arg1)
     int currentPercent = imageWin->currentScalePercent();
     ui->horizontalSliderScale->setValue(currentPercent);
     ui->labelScale->setText(tr("当前缩放：%1%").arg(currentPercent));
+    updateCommandActions();
+}
+
+// 完整图片解码完成：启用命令并同步缩放比例
+void MainWindow::onImageReady()
+{
+    on_mdiArea_subWindowActivated(ui->mdiArea->activeSubWindow());
+}
+
+// 图像处理和撤销/重做在当前图片已完整解码或当前为视频窗口（实时处理）时可用，保存仅限图片
+void MainWindow::updateCommandActions()
+{
+    FileViewSubWindow *imageWin = currentImageSubWindow();
+    const bool ready = imageWin && imageWin->acceptsCommands();
+    const QList<QAction *> actions = { ui->action_G, ui->action_T, ui->action_2, ui->action_3,
+                                       ui->action_4, ui->action_Z, ui->action_Y };
+    for (QAction *action : actions) {
+        action->setEnabled(ready);
+    }
+    ui->actionSave_S->setEnabled(imageWin && imageWin->isImageReady());
+    ui->actionExportVideo->setEnabled(imageWin && imageWin->canExportVideo());
 }
 
 // 灰度化
@@ -254,6 +478,10 @@ void MainWindow::on_action_G_triggered()
     m_edgeThresholdSlider->setVisible(false);
     m_edgeThresholdSlider->setEnabled(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    m_meanRadiusSlider->setEnabled(false);
+    meanValueLabel->setVisible(false);
 
     // 创建并应用灰度化命令
     imageWin->applyImageCommand(new GrayscaleCommand(imageWin->getCurrentImage()));
@@ -278,6 +506,10 @@ void MainWindow::on_action_T_triggered()
     m_edgeThresholdSlider->setVisible(false);
     m_edgeThresholdSlider->setEnabled(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    m_meanRadiusSlider->setEnabled(false);
+    meanValueLabel->setVisible(false);
 
     // 更新数值显示
     binaryValueLabel->setText(QString::number(m_binaryThreshold));
@@ -286,7 +518,7 @@ void MainWindow::on_action_T_triggered()
     imageWin->applyImageCommand(new BinaryCommand(imageWin->getCurrentImage(), m_binaryThreshold));
 }
 
-// 3×3均值滤波
+// 均值滤波
 void MainWindow::on_action_2_triggered()
 {
     FileViewSubWindow *imageWin = currentImageSubWindow();
@@ -305,9 +537,16 @@ void MainWindow::on_action_2_triggered()
     m_edgeThresholdSlider->setVisible(false);
     m_edgeThresholdSlider->setEnabled(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(true);
+    m_meanRadiusSlider->setVisible(true);
+    m_meanRadiusSlider->setEnabled(true);
+    meanValueLabel->setVisible(true);
+
+    // 更新数值显示
+    meanValueLabel->setText(QString::number(m_meanRadius));
 
     // 创建并应用均值滤波命令
-    imageWin->applyImageCommand(new MeanFilterCommand(imageWin->getCurrentImage()));
+    imageWin->applyImageCommand(new MeanFilterCommand(imageWin->getCurrentImage(), m_meanRadius));
 }
 
 // 伽马变换
@@ -329,6 +568,10 @@ void MainWindow::on_action_3_triggered()
     m_edgeThresholdSlider->setVisible(false);
     m_edgeThresholdSlider->setEnabled(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    m_meanRadiusSlider->setEnabled(false);
+    meanValueLabel->setVisible(false);
 
     // 更新数值显示
     gammaValueLabel->setText(QString::number(m_gammaValue, 'f', 1));
@@ -356,6 +599,10 @@ void MainWindow::on_action_4_triggered()
     m_edgeThresholdSlider->setVisible(true);
     m_edgeThresholdSlider->setEnabled(true);
     edgeValueLabel->setVisible(true);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    m_meanRadiusSlider->setEnabled(false);
+    meanValueLabel->setVisible(false);
 
     // 更新数值显示
     edgeValueLabel->setText(QString::number(m_edgeThreshold));
@@ -395,12 +642,18 @@ void MainWindow::on_sliderPressed()
     m_timer->stop();
 }
 
-// 二值化阈值滑块变化（仅更新显示）
+// 二值化阈值滑块变化（更新显示并实时预览）
 void MainWindow::on_binaryThresholdSlider_valueChanged(int value)
 {
     m_binaryThreshold = value;
-    // 只更新数值显示，不立即处理图像
+    // 更新数值显示，全分辨率处理在释放滑块后进行
     binaryValueLabel->setText(QString::number(value));
+
+    // 拖动过程中在低分辨率代理图上实时预览
+    FileViewSubWindow *imageWin = currentImageSubWindow();
+    if (imageWin && m_binaryThresholdSlider->isSliderDown()) {
+        imageWin->previewCommand(BinaryCommand(QImage(), value));
+    }
 }
 
 // 二值化阈值滑块释放时的处理
@@ -419,12 +672,18 @@ void MainWindow::on_binaryThresholdSlider_released()
     });
 }
 
-// 伽马值滑块变化（仅更新显示）
+// 伽马值滑块变化（更新显示并实时预览）
 void MainWindow::on_gammaValueSlider_valueChanged(int value)
 {
     m_gammaValue = value / 10.0;
-    // 只更新数值显示，不立即处理图像
+    // 更新数值显示，全分辨率处理在释放滑块后进行
     gammaValueLabel->setText(QString::number(m_gammaValue, 'f', 1));
+
+    // 拖动过程中在低分辨率代理图上实时预览
+    FileViewSubWindow *imageWin = currentImageSubWindow();
+    if (imageWin && m_gammaValueSlider->isSliderDown()) {
+        imageWin->previewCommand(GammaCorrectionCommand(QImage(), m_gammaValue));
+    }
 }
 
 // 伽马值滑块释放时的处理
@@ -443,12 +702,18 @@ void MainWindow::on_gammaValueSlider_released()
     });
 }
 
-// 边缘检测阈值滑块变化（仅更新显示）
+// 边缘检测阈值滑块变化（更新显示并实时预览）
 void MainWindow::on_edgeThresholdSlider_valueChanged(int value)
 {
     m_edgeThreshold = value;
-    // 只更新数值显示，不立即处理图像
+    // 更新数值显示，全分辨率处理在释放滑块后进行
     edgeValueLabel->setText(QString::number(value));
+
+    // 拖动过程中在低分辨率代理图上实时预览
+    FileViewSubWindow *imageWin = currentImageSubWindow();
+    if (imageWin && m_edgeThresholdSlider->isSliderDown()) {
+        imageWin->previewCommand(EdgeDetectionCommand(QImage(), value));
+    }
 }
 
 // 边缘检测阈值滑块释放时的处理
@@ -467,6 +732,30 @@ void MainWindow::on_edgeThresholdSlider_released()
     });
 }
 
+// 均值滤波半径滑块变化（仅更新显示）
+void MainWindow::on_meanRadiusSlider_valueChanged(int value)
+{
+    m_meanRadius = value;
+    // 只更新数值显示，不立即处理图像
+    meanValueLabel->setText(QString::number(value));
+}
+
+// 均值滤波半径滑块释放时的处理
+void MainWindow::on_meanRadiusSlider_released()
+{
+    // 启动定时器，延迟处理图像
+    m_timer->start(300);
+    // 连接定时器超时信号到处理函数
+    connect(m_timer, &QTimer::timeout, this, [=]() {
+        FileViewSubWindow *imageWin = currentImageSubWindow();
+        if (!imageWin) return;
+        // 重新应用均值滤波命令
+        imageWin->applyImageCommand(new MeanFilterCommand(imageWin->getCurrentImage(), m_meanRadius));
+        // 断开连接，避免重复处理
+        disconnect(m_timer, &QTimer::timeout, nullptr, nullptr);
+    });
+}
+
 // 处理命令应用信号
 void MainWindow::onCommandApplied(ImageCommand *command)
 {
@@ -483,6 +772,10 @@ void MainWindow::onCommandApplied(ImageCommand *command)
     m_edgeThresholdSlider->setVisible(false);
     m_edgeThresholdSlider->setEnabled(false);
     edgeValueLabel->setVisible(false);
+    meanLabel->setVisible(false);
+    m_meanRadiusSlider->setVisible(false);
+    m_meanRadiusSlider->setEnabled(false);
+    meanValueLabel->setVisible(false);
     
     // 根据命令类型更新滑块、标签和数值显示
     if (BinaryCommand *binaryCommand = dynamic_cast<BinaryCommand*>(command)) {
@@ -518,6 +811,20 @@ void MainWindow::onCommandApplied(ImageCommand *command)
         m_edgeThresholdSlider->setVisible(true);
         m_edgeThresholdSlider->setEnabled(true);
         edgeValueLabel->setVisible(true);
+    } else if (MeanFilterCommand *meanCommand = dynamic_cast<MeanFilterCommand*>(command)) {
+        // 均值滤波命令
+        m_meanRadius = meanCommand->radius();
+        m_meanRadiusSlider->setValue(m_meanRadius);
+        meanValueLabel->setText(QString::number(m_meanRadius));
+        
+        // 显示均值滤波控件
+        meanLabel->setVisible(true);
+        m_meanRadiusSlider->setVisible(true);
+        m_meanRadiusSlider->setEnabled(true);
+        meanValueLabel->setVisible(true);
     }
+
+    // 视频窗口的处理链变化后同步导出是否可用
+    updateCommandActions();
 }
 
@@ -23,6 +23,15 @@ private slots:
 
     void on_actionOpen_O_triggered();
 
+    void on_actionSave_S_triggered();
+
+    // 视频窗口按当前处理链离线导出
+    void on_actionExportVideo_triggered();
+
+    // 性能跟踪开关与导出（Chrome trace JSON）
+    void on_actionTrace_toggled(bool checked);
+    void on_actionExportTrace_triggered();
+
     void on_horizontalSliderScale_valueChanged(int value);
 
     void on_mdiArea_subWindowActivated(QMdiSubWindow *arg1);
@@ -46,29 +55,39 @@ private slots:
     void on_gammaValueSlider_released();
     void on_edgeThresholdSlider_valueChanged(int value);
     void on_edgeThresholdSlider_released();
+    void on_meanRadiusSlider_valueChanged(int value);
+    void on_meanRadiusSlider_released();
     void onCommandApplied(ImageCommand *command); // 处理命令应用信号
+    void onImageReady(); // 图片完整解码完成
+    void showOperationTime(const QString &name, qint64 nsecs, double megapixels); // 状态栏显示操作耗时
 
 private:
     Ui::MainWindow *ui;
     // 获取当前激活的图片子窗口（过滤视频窗口）
     FileViewSubWindow* currentImageSubWindow();
+    // 根据当前图片是否已解码启用/禁用处理命令
+    void updateCommandActions();
 
     // 工具栏滑块控件
     QSlider *m_binaryThresholdSlider;
     QSlider *m_gammaValueSlider;
     QSlider *m_edgeThresholdSlider;
+    QSlider *m_meanRadiusSlider;
     // 滑块标签控件
     QLabel *binaryLabel; // 二值化阈值标签
     QLabel *gammaLabel; // 伽马值标签
     QLabel *edgeLabel; // 边缘检测阈值标签
+    QLabel *meanLabel; // 均值滤波半径标签
     // 滑块数值显示标签
     QLabel *binaryValueLabel; // 二值化阈值数值显示
     QLabel *gammaValueLabel; // 伽马值数值显示
     QLabel *edgeValueLabel; // 边缘检测阈值数值显示
+    QLabel *meanValueLabel; // 均值滤波半径数值显示
     // 滑块当前值
     int m_binaryThreshold;
     double m_gammaValue;
     int m_edgeThreshold;
+    int m_meanRadius;
     // 用于延迟处理的定时器
     QTimer *m_timer; // 用于滑块停止拖动后延迟处理
 };
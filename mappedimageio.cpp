@@ -0,0 +1,404 @@
+#include "mappedimageio.h"
+#include "tilescheduler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+namespace {
+
+constexpr char RawMagic[8] = { 'P', 'S', 'V', 'R', 'A', 'W', '0', '1' };
+
+// 文件头解析结果
+struct Layout
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;           // 每像素采样数（PNM/PAM）
+    int maxval = 255;
+    qint64 offset = 0;          // 像素数据在文件中的偏移
+    qsizetype bytesPerLine = 0;
+    QImage::Format format = QImage::Format_Invalid;  // 可零拷贝包装时的 QImage 格式
+};
+
+// 映射随 QImage 的生命周期：最后一个引用释放时解除映射并关闭文件
+struct Mapping
+{
+    explicit Mapping(const QString &filePath) : file(filePath) {}
+    QFile file;
+    uchar *data = nullptr;
+};
+
+void releaseMapping(void *info)
+{
+    Mapping *mapping = static_cast<Mapping *>(info);
+    if (mapping->data) {
+        mapping->file.unmap(mapping->data);
+    }
+    delete mapping;
+}
+
+bool isSpace(uchar c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// 跳过空白和 # 注释
+void skipSpace(const uchar *data, qint64 size, qint64 &pos)
+{
+    while (pos < size) {
+        if (data[pos] == '#') {
+            while (pos < size && data[pos] != '\n') ++pos;
+        } else if (isSpace(data[pos])) {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+}
+
+bool readNumber(const uchar *data, qint64 size, qint64 &pos, int &value)
+{
+    skipSpace(data, size, pos);
+    if (pos >= size || data[pos] < '0' || data[pos] > '9') return false;
+    qint64 number = 0;
+    while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+        number = number * 10 + (data[pos++] - '0');
+        if (number > std::numeric_limits<int>::max()) return false;
+    }
+    value = int(number);
+    return true;
+}
+
+// PAM 头：每行一个 "关键字 值"，以 ENDHDR 结束
+bool parsePam(const uchar *data, qint64 size, Layout &layout)
+{
+    qint64 pos = 2;
+    while (pos < size) {
+        skipSpace(data, size, pos);
+        qint64 end = pos;
+        while (end < size && !isSpace(data[end])) ++end;
+        const QByteArray key(reinterpret_cast<const char *>(data + pos), end - pos);
+        pos = end;
+
+        if (key == "ENDHDR") {
+            // 像素数据从 ENDHDR 行的换行符之后开始
+            while (pos < size && data[pos] != '\n') ++pos;
+            layout.offset = pos + 1;
+            return layout.width > 0 && layout.height > 0 && layout.channels > 0;
+        }
+        if (key == "WIDTH") {
+            if (!readNumber(data, size, pos, layout.width)) return false;
+        } else if (key == "HEIGHT") {
+            if (!readNumber(data, size, pos, layout.height)) return false;
+        } else if (key == "DEPTH") {
+            if (!readNumber(data, size, pos, layout.channels)) return false;
+        } else if (key == "MAXVAL") {
+            if (!readNumber(data, size, pos, layout.maxval)) return false;
+        } else {
+            // TUPLTYPE 等其余关键字：忽略整行
+            while (pos < size && data[pos] != '\n') ++pos;
+        }
+    }
+    return false;
+}
+
+bool parsePnm(const uchar *data, qint64 size, Layout &layout)
+{
+    if (size < 3 || data[0] != 'P') return false;
+
+    if (data[1] == '7') {
+        if (!parsePam(data, size, layout)) return false;
+    } else {
+        if (data[1] == '5') {
+            layout.channels = 1;
+        } else if (data[1] == '6') {
+            layout.channels = 3;
+        } else {
+            return false;  // 只支持二进制的 P5/P6/P7
+        }
+        qint64 pos = 2;
+        if (!readNumber(data, size, pos, layout.width) || !readNumber(data, size, pos, layout.height)
+            || !readNumber(data, size, pos, layout.maxval)) {
+            return false;
+        }
+        // maxval 之后恰好一个空白字符
+        layout.offset = pos + 1;
+    }
+
+    if (layout.width <= 0 || layout.height <= 0 || layout.channels < 1 || layout.channels > 4
+        || layout.maxval < 1 || layout.maxval > 65535) {
+        return false;
+    }
+    const int sampleBytes = layout.maxval > 255 ? 2 : 1;
+    layout.bytesPerLine = qsizetype(layout.width) * layout.channels * sampleBytes;
+
+    if (layout.maxval == 255) {
+        switch (layout.channels) {
+        case 1: layout.format = QImage::Format_Grayscale8; break;
+        case 3: layout.format = QImage::Format_RGB888; break;
+        case 4: layout.format = QImage::Format_RGBA8888; break;
+        default: break;
+        }
+    }
+    return true;
+}
+
+bool isRawFormat(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Grayscale8:
+    case QImage::Format_RGB888:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBA8888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool parseRaw(const uchar *data, qint64 size, Layout &layout)
+{
+    if (size < MappedImageIO::RawHeaderSize || std::memcmp(data, RawMagic, sizeof(RawMagic)) != 0) {
+        return false;
+    }
+    layout.width = int(qFromLittleEndian<quint32>(data + 8));
+    layout.height = int(qFromLittleEndian<quint32>(data + 12));
+    layout.bytesPerLine = qFromLittleEndian<quint32>(data + 16);
+    layout.format = QImage::Format(qFromLittleEndian<quint32>(data + 20));
+    layout.offset = MappedImageIO::RawHeaderSize;
+
+    if (layout.width <= 0 || layout.height <= 0 || !isRawFormat(layout.format)) return false;
+    return layout.bytesPerLine >= qsizetype(layout.width) * QImage::toPixelFormat(layout.format).bitsPerPixel() / 8;
+}
+
+bool parseHeader(const uchar *data, qint64 size, Layout &layout)
+{
+    if (size >= qint64(sizeof(RawMagic)) && std::memcmp(data, RawMagic, sizeof(RawMagic)) == 0) {
+        return parseRaw(data, size, layout);
+    }
+    return parsePnm(data, size, layout);
+}
+
+// 无法零拷贝时复制转换为8位：16位采样按大端读取并缩放到 0~255，灰度+透明通道展开为 RGBA
+QImage convertSamples(const uchar *payload, const Layout &layout)
+{
+    const int channels = layout.channels;
+    const int sampleBytes = layout.maxval > 255 ? 2 : 1;
+    const QImage::Format format = channels == 1 ? QImage::Format_Grayscale8
+                                  : channels == 3 ? QImage::Format_RGB888
+                                                  : QImage::Format_RGBA8888;
+    QImage image(layout.width, layout.height, format);
+    if (image.isNull()) return image;
+
+    const int outChannels = channels == 2 ? 4 : channels;
+    const int maxval = layout.maxval;
+    uchar *bits = image.bits();
+    const qsizetype stride = image.bytesPerLine();
+
+    TileScheduler::forEachBand(layout.height, layout.bytesPerLine, 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const uchar *in = payload + qsizetype(y) * layout.bytesPerLine;
+            uchar *out = bits + qsizetype(y) * stride;
+            for (int x = 0; x < layout.width; ++x, out += outChannels) {
+                for (int c = 0; c < channels; ++c, in += sampleBytes) {
+                    const int sample = sampleBytes == 2 ? (in[0] << 8) | in[1] : in[0];
+                    const uchar value = uchar(qMin(255, (sample * 255 + maxval / 2) / maxval));
+                    if (channels == 2) {
+                        if (c == 0) {
+                            out[0] = out[1] = out[2] = value;
+                        } else {
+                            out[3] = value;
+                        }
+                    } else {
+                        out[c] = value;
+                    }
+                }
+            }
+        }
+    });
+    return image;
+}
+
+} // namespace
+
+namespace MappedImageIO {
+
+bool supportsSuffix(const QString &suffix)
+{
+    const QString s = suffix.toLower();
+    return s == "pgm" || s == "ppm" || s == "pam" || s == "praw";
+}
+
+QSize readSize(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return QSize();
+
+    // 文件头都在开头的几 KB 内
+    const QByteArray head = file.read(4096);
+    Layout layout;
+    if (!parseHeader(reinterpret_cast<const uchar *>(head.constData()), head.size(), layout)) {
+        return QSize();
+    }
+    return QSize(layout.width, layout.height);
+}
+
+QImage read(const QString &filePath, QString *errorString)
+{
+    Mapping *mapping = new Mapping(filePath);
+    auto fail = [&](const QString &message) {
+        if (errorString) *errorString = message;
+        releaseMapping(mapping);
+        return QImage();
+    };
+
+    if (!mapping->file.open(QIODevice::ReadOnly)) {
+        return fail(mapping->file.errorString());
+    }
+    const qint64 size = mapping->file.size();
+    mapping->data = mapping->file.map(0, size);
+    if (!mapping->data) {
+        return fail(QStringLiteral("无法映射文件：%1").arg(mapping->file.errorString()));
+    }
+
+    Layout layout;
+    if (!parseHeader(mapping->data, size, layout)) {
+        return fail(QStringLiteral("文件头无效：%1").arg(filePath));
+    }
+    if (layout.offset + qint64(layout.bytesPerLine) * layout.height > size) {
+        return fail(QStringLiteral("像素数据不完整：%1").arg(filePath));
+    }
+
+    const uchar *payload = mapping->data + layout.offset;
+
+    // 8位数据直接包装映射区；32位像素要求按4字节对齐（映射起始地址按页对齐，只需检查偏移和行宽）
+    if (layout.format != QImage::Format_Invalid) {
+        const int depth = QImage::toPixelFormat(layout.format).bitsPerPixel();
+        const bool aligned = depth < 32 || (quintptr(payload) % 4 == 0 && layout.bytesPerLine % 4 == 0);
+        if (aligned) {
+            return QImage(payload, layout.width, layout.height, layout.bytesPerLine, layout.format,
+                          releaseMapping, mapping);
+        }
+        if (layout.channels == 0) {
+            // .praw 未对齐：复制一份（文件头固定64字节，正常写出的文件不会出现）
+            const QImage copy = QImage(payload, layout.width, layout.height, layout.bytesPerLine,
+                                       layout.format).copy();
+            releaseMapping(mapping);
+            return copy;
+        }
+    }
+
+    const QImage image = convertSamples(payload, layout);
+    releaseMapping(mapping);
+    return image;
+}
+
+bool write(const QImage &image, const QString &filePath, QString *errorString)
+{
+    auto fail = [&](const QString &message) {
+        if (errorString) *errorString = message;
+        return false;
+    };
+    if (image.isNull()) return fail(QStringLiteral("图片为空"));
+
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    QImage::Format target;
+    QByteArray header;
+
+    if (suffix == "praw") {
+        target = isRawFormat(image.format()) ? image.format()
+                 : image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    } else if (suffix == "pgm") {
+        target = QImage::Format_Grayscale8;
+        header = QStringLiteral("P5\n%1 %2\n255\n").arg(image.width()).arg(image.height()).toLatin1();
+    } else if (suffix == "ppm") {
+        target = QImage::Format_RGB888;
+        header = QStringLiteral("P6\n%1 %2\n255\n").arg(image.width()).arg(image.height()).toLatin1();
+    } else if (suffix == "pam") {
+        int depth;
+        const char *tupleType;
+        if (image.format() == QImage::Format_Grayscale8) {
+            target = QImage::Format_Grayscale8;
+            depth = 1;
+            tupleType = "GRAYSCALE";
+        } else if (image.hasAlphaChannel()) {
+            target = QImage::Format_RGBA8888;
+            depth = 4;
+            tupleType = "RGB_ALPHA";
+        } else {
+            target = QImage::Format_RGB888;
+            depth = 3;
+            tupleType = "RGB";
+        }
+        header = QStringLiteral("P7\nWIDTH %1\nHEIGHT %2\nDEPTH %3\nMAXVAL 255\nTUPLTYPE %4\n")
+                     .arg(image.width()).arg(image.height()).arg(depth).arg(tupleType).toLatin1();
+        // 4通道时用注释行补齐文件头，使像素数据按4字节对齐，读取时可零拷贝
+        if (depth == 4) {
+            const int headerSize = header.size() + 2 + 7;  // 注释行 "#...\n" 至少2字节，"ENDHDR\n" 7字节
+            header += '#' + QByteArray((4 - headerSize % 4) % 4, ' ') + '\n';
+        }
+        header += "ENDHDR\n";
+    } else {
+        return fail(QStringLiteral("不支持的格式：%1").arg(suffix));
+    }
+
+    const QImage source = image.format() == target ? image : image.convertToFormat(target);
+    const qsizetype rowBytes = suffix == "praw"
+                                   ? source.bytesPerLine()
+                                   : qsizetype(source.width()) * source.depth() / 8;
+    if (suffix == "praw") {
+        header = QByteArray(RawHeaderSize, '\0');
+        uchar *h = reinterpret_cast<uchar *>(header.data());
+        std::memcpy(h, RawMagic, sizeof(RawMagic));
+        qToLittleEndian<quint32>(quint32(source.width()), h + 8);
+        qToLittleEndian<quint32>(quint32(source.height()), h + 12);
+        qToLittleEndian<quint32>(quint32(rowBytes), h + 16);
+        qToLittleEndian<quint32>(quint32(source.format()), h + 20);
+    }
+
+    // 写入同目录的临时文件，完成后再替换目标：source 可能正是目标文件的零拷贝映射（打开后原地保存），
+    // 直接截断目标会使映射页变为全零（Windows 上截断已映射的文件则会失败）
+    // 临时文件先扩展到最终大小再映射，像素按行并行写入映射区
+    const qint64 total = header.size() + qint64(rowBytes) * source.height();
+    const QFileInfo info(filePath);
+    QTemporaryFile file(info.absolutePath() + "/." + info.fileName() + ".XXXXXX");
+    if (!file.open() || !file.resize(total)) {
+        return fail(file.errorString());
+    }
+    uchar *map = file.map(0, total);
+    if (!map) return fail(file.errorString());
+    // 临时文件默认仅所有者可读写，沿用原文件（或新建文件的常规）权限
+    file.setPermissions(info.exists() ? info.permissions()
+                                      : QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::ReadOther);
+
+    std::memcpy(map, header.constData(), header.size());
+    uchar *payload = map + header.size();
+    TileScheduler::forEachBand(source.height(), rowBytes, 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            std::memcpy(payload + qsizetype(y) * rowBytes, source.constScanLine(y), rowBytes);
+        }
+    });
+
+    file.unmap(map);
+    file.close();
+    // 改名覆盖目标（POSIX rename(2) / Windows MoveFileEx(MOVEFILE_REPLACE_EXISTING)），替换是原子的：
+    // 任何时刻目标要么是完整的旧文件，要么是完整的新文件。旧文件被映射时，Linux 上映射仍指向旧内容；
+    // Windows 上替换失败，目标保持原样，临时文件随 QTemporaryFile 析构删除
+    std::error_code error;
+    std::filesystem::rename(QFileInfo(file.fileName()).filesystemAbsoluteFilePath(),
+                            info.filesystemAbsoluteFilePath(), error);
+    if (error) {
+        return fail(QStringLiteral("无法替换文件：%1（%2）")
+                        .arg(filePath, QString::fromLocal8Bit(error.message())));
+    }
+    file.setAutoRemove(false);  // 临时文件已改名为目标
+    return true;
+}
+
+} // namespace MappedImageIO
@@ -0,0 +1,32 @@
+#ifndef MAPPEDIMAGEIO_H
+#define MAPPEDIMAGEIO_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// 基于内存映射的无压缩图片读写：PGM(P5) / PPM(P6) / PAM(P7) 以及带 64 字节文件头的原始格式 .praw
+// 读取时映射整个文件，8位像素数据直接作为 QImage 的缓冲区（不复制，图片释放时解除映射）；
+// 写入时先把同目录的临时文件扩展到最终大小再映射，像素按行直接写入映射区，完成后替换目标文件（可以覆盖正被映射读取的源文件）
+// 以下情况退回复制：16位采样（maxval > 255）、PAM 的灰度+透明通道、32位像素数据未按4字节对齐
+namespace MappedImageIO {
+
+// .praw 文件头：8字节标识 + 宽、高、每行字节数、QImage::Format（均为小端 quint32），其余保留为0
+constexpr int RawHeaderSize = 64;
+
+// 按后缀判断是否由本模块读写（ppm/pgm/pam/praw）
+bool supportsSuffix(const QString &suffix);
+
+// 只解析文件头得到图片尺寸，失败返回无效尺寸
+QSize readSize(const QString &filePath);
+
+// 读取图片，失败返回空图像并写入 errorString
+QImage read(const QString &filePath, QString *errorString = nullptr);
+
+// 按后缀选择格式写入：pgm 写灰度，ppm 写 RGB，pam 按是否有透明通道写 RGB_ALPHA / RGB / GRAYSCALE，
+// praw 直接写 QImage 的内存格式
+bool write(const QImage &image, const QString &filePath, QString *errorString = nullptr);
+
+} // namespace MappedImageIO
+
+#endif // MAPPEDIMAGEIO_H
@@ -1,48 +1,46 @@
 #include "meanfiltercommand.h"
+#include "pixelview.h"
 
-MeanFilterCommand::MeanFilterCommand(const QImage &originalImage)
-    : ImageCommand(originalImage, "3×3均值滤波")
+MeanFilterCommand::MeanFilterCommand(const QImage &originalImage, int radius,
+                                     BoxFilter::BorderMode borderMode)
+    : ImageCommand(originalImage, QString("%1×%1均值滤波").arg(2 * qBound(1, radius, BoxFilter::MaxRadius) + 1))
+    , m_radius(qBound(1, radius, BoxFilter::MaxRadius))
+    , m_borderMode(borderMode)
 {
 }
 
-QImage MeanFilterCommand::execute()
+QImage MeanFilterCommand::apply(const QImage &input) const
 {
-    QImage resultImage = m_originalImage.copy();
-    int width = resultImage.width();
-    int height = resultImage.height();
-
-    // 3×3均值滤波
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int sumR = 0, sumG = 0, sumB = 0;
-            int count = 0;
+    return applyInto(input, QImage());
+}
 
-            // 遍历3×3邻域
-            for (int ky = -1; ky <= 1; ++ky) {
-                for (int kx = -1; kx <= 1; ++kx) {
-                    int nx = x + kx;
-                    int ny = y + ky;
+QImage MeanFilterCommand::applyInto(const QImage &input, QImage target) const
+{
+    // 滑动窗口均值滤波，每像素代价与半径无关
+    // 32位图像拆为 R/G/B 平面处理（连续的单通道行可向量化，含布局转换仍快于交错布局）；灰度图本身即单平面
+    if (PixelView::isGray8(input)) {
+        return BoxFilter::filter(input, m_radius, m_borderMode, std::move(target));
+    }
+    return BoxFilter::filterPlanar(input, m_radius, m_borderMode, std::move(target));
+}
 
-                    // 检查边界
-                    if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                        QColor pixelColor = m_originalImage.pixelColor(nx, ny);
-                        sumR += pixelColor.red();
-                        sumG += pixelColor.green();
-                        sumB += pixelColor.blue();
-                        count++;
-                    }
-                }
-            }
+QImage::Format MeanFilterCommand::resultFormat(const QImage &input) const
+{
+    if (PixelView::isGray8(input)) return QImage::Format_Grayscale8;
+    return input.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+}
 
-            // 计算平均值
-            int avgR = sumR / count;
-            int avgG = sumG / count;
-            int avgB = sumB / count;
+int MeanFilterCommand::radius() const
+{
+    return m_radius;
+}
 
-            // 设置滤波后的像素
-            resultImage.setPixelColor(x, y, QColor(avgR, avgG, avgB));
-        }
-    }
+BoxFilter::BorderMode MeanFilterCommand::borderMode() const
+{
+    return m_borderMode;
+}
 
-    return resultImage;
+QString MeanFilterCommand::cacheKey() const
+{
+    return QString("mean:%1:%2").arg(m_radius).arg(int(m_borderMode));
 }
@@ -2,12 +2,25 @@
 #define MEANFILTERCOMMAND_H
 
 #include "imagecommand.h"
+#include "boxfilter.h"
 
 class MeanFilterCommand : public ImageCommand
 {
 public:
-    explicit MeanFilterCommand(const QImage &originalImage);
-    QImage execute() override;
+    explicit MeanFilterCommand(const QImage &originalImage, int radius = 1,
+                               BoxFilter::BorderMode borderMode = BoxFilter::BorderMode::Clamp);
+    QImage apply(const QImage &input) const override;
+    QImage applyInto(const QImage &input, QImage target) const override;
+    QImage::Format resultFormat(const QImage &input) const override;
+    QString cacheKey() const override;
+
+    // 滤波半径：窗口大小为 (2r+1)×(2r+1)
+    int radius() const;
+    BoxFilter::BorderMode borderMode() const;
+
+private:
+    int m_radius;
+    BoxFilter::BorderMode m_borderMode;
 };
 
-#endif // MEANFILTERCOMMAND_H
\ No newline at end of file
+#endif // MEANFILTERCOMMAND_H
@@ -0,0 +1,144 @@
+#include "perftrace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+std::atomic<bool> PerfTrace::s_enabled { false };
+
+namespace {
+
+struct Buffer
+{
+    QMutex mutex;
+    QVector<PerfTrace::Event> events;
+    qsizetype next = 0;     // 下一个写入位置（已写满时即最旧的事件）
+};
+
+Buffer &buffer()
+{
+    static Buffer b;
+    return b;
+}
+
+const QElapsedTimer &clock()
+{
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+} // namespace
+
+void PerfTrace::setEnabled(bool enabled)
+{
+    clock();  // 跟踪起点
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void PerfTrace::initFromEnvironment()
+{
+    const QString value = qEnvironmentVariable("PSVIDIO_TRACE");
+    if (value.isEmpty()) return;
+
+    setEnabled(true);
+}
+
+void PerfTrace::writeEnvironmentTrace()
+{
+    const QString value = qEnvironmentVariable("PSVIDIO_TRACE");
+    if (value.endsWith(".json", Qt::CaseInsensitive)) {
+        writeChromeTrace(value);
+    }
+}
+
+qint64 PerfTrace::now()
+{
+    return clock().nsecsElapsed();
+}
+
+void PerfTrace::record(const char *name, const QString &detail, qint64 startNs, qint64 durationNs,
+                       double megapixels)
+{
+    Event event;
+    event.name = QString::fromUtf8(name);
+    event.detail = detail;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.megapixels = megapixels;
+    event.threadId = quint64(quintptr(QThread::currentThreadId()));
+
+    Buffer &b = buffer();
+    QMutexLocker locker(&b.mutex);
+    if (b.events.size() < Capacity) {
+        b.events.append(std::move(event));
+    } else {
+        b.events[b.next] = std::move(event);
+        b.next = (b.next + 1) % Capacity;
+    }
+}
+
+QList<PerfTrace::Event> PerfTrace::events()
+{
+    Buffer &b = buffer();
+    QMutexLocker locker(&b.mutex);
+    // 按写入顺序返回
+    QList<Event> result = b.events.mid(b.next);
+    result += b.events.mid(0, b.next);
+    return result;
+}
+
+void PerfTrace::clear()
+{
+    Buffer &b = buffer();
+    QMutexLocker locker(&b.mutex);
+    b.events.clear();
+    b.next = 0;
+}
+
+// Chrome trace 格式：每个作用域为一个完整事件（ph = "X"），时间单位为微秒
+bool PerfTrace::writeChromeTrace(const QString &filePath, QString *errorString)
+{
+    const QList<Event> list = events();
+
+    QJsonArray traceEvents;
+    for (const Event &event : list) {
+        QJsonObject args;
+        if (!event.detail.isEmpty()) args["detail"] = event.detail;
+        if (event.megapixels > 0) {
+            args["megapixels"] = event.megapixels;
+            if (event.durationNs > 0) args["mp_per_s"] = event.megapixels / (event.durationNs / 1e9);
+        }
+
+        QJsonObject json;
+        json["name"] = event.detail.isEmpty() ? event.name : event.name + ": " + event.detail;
+        json["cat"] = "psvidio";
+        json["ph"] = "X";
+        json["ts"] = event.startNs / 1000.0;
+        json["dur"] = event.durationNs / 1000.0;
+        json["pid"] = qint64(QCoreApplication::applicationPid());
+        json["tid"] = qint64(event.threadId);
+        json["args"] = args;
+        traceEvents.append(json);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorString) *errorString = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
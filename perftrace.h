@@ -0,0 +1,77 @@
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QString>
+#include <QList>
+#include <QSize>
+#include <QtGlobal>
+#include <atomic>
+
+// 轻量级性能跟踪：作用域计时，记录名称、耗时、处理的百万像素数和线程
+// 未启用时 Scope 只读取一次原子标记，不取时间、不分配内存；启用后事件保存在定长环形缓冲中，
+// 可导出为 Chrome / Perfetto 的 trace JSON（chrome://tracing 或 ui.perfetto.dev 打开）
+// 启动时环境变量 PSVIDIO_TRACE 非空即启用；其值以 .json 结尾时程序退出前写出到该文件，
+// 界面中也可随时开关跟踪并导出
+class PerfTrace
+{
+public:
+    // 环形缓冲容量（事件数），超出后覆盖最旧的事件
+    static constexpr int Capacity = 1 << 16;
+
+    struct Event
+    {
+        QString name;
+        QString detail;         // 附加说明（如命令名称）
+        qint64 startNs = 0;     // 相对跟踪起点
+        qint64 durationNs = 0;
+        double megapixels = 0;
+        quint64 threadId = 0;
+    };
+
+    static double megapixels(const QSize &size) { return qint64(size.width()) * size.height() / 1e6; }
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    // 读取 PSVIDIO_TRACE 环境变量
+    static void initFromEnvironment();
+    // 程序退出前调用：PSVIDIO_TRACE 为 .json 文件路径时写出跟踪
+    static void writeEnvironmentTrace();
+
+    static QList<Event> events();
+    static void clear();
+    static bool writeChromeTrace(const QString &filePath, QString *errorString = nullptr);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name, double megapixels = 0)
+            : m_name(name), m_megapixels(megapixels), m_startNs(isEnabled() ? now() : -1) {}
+        ~Scope() { if (m_startNs >= 0) record(m_name, m_detail, m_startNs, now() - m_startNs, m_megapixels); }
+        Q_DISABLE_COPY(Scope)
+
+        bool isActive() const { return m_startNs >= 0; }
+        // 只在 isActive() 时调用，避免未启用时构造字符串
+        void setDetail(const QString &detail) { m_detail = detail; }
+        void setMegapixels(double megapixels) { m_megapixels = megapixels; }
+
+    private:
+        const char *m_name;
+        QString m_detail;
+        double m_megapixels;
+        qint64 m_startNs;
+    };
+
+private:
+    static qint64 now();
+    static void record(const char *name, const QString &detail, qint64 startNs, qint64 durationNs,
+                       double megapixels);
+
+    static std::atomic<bool> s_enabled;
+};
+
+#define PERFTRACE_CONCAT_(a, b) a##b
+#define PERFTRACE_CONCAT(a, b) PERFTRACE_CONCAT_(a, b)
+// 跟踪当前作用域：PERF_TRACE("名称") 或 PERF_TRACE("名称", 百万像素数)
+#define PERF_TRACE(...) PerfTrace::Scope PERFTRACE_CONCAT(perfTraceScope_, __LINE__)(__VA_ARGS__)
+
+#endif // PERFTRACE_H
@@ -0,0 +1,138 @@
+#ifndef PIXELVIEW_H
+#define PIXELVIEW_H
+
+#include <QImage>
+#include <QRgb>
+
+// 基于 scanLine/constScanLine 的类型化像素访问层
+// 命令直接按行遍历原始字节，避免 pixelColor/setPixelColor 的逐像素 QColor 构造与格式转换
+namespace PixelView {
+
+// 32位像素格式（Format_RGB32 / Format_ARGB32），每像素一个 QRgb
+struct Rgb32
+{
+    using Pixel = QRgb;
+};
+
+// 8位灰度格式（Format_Grayscale8），每像素一个字节
+struct Gray8
+{
+    using Pixel = uchar;
+};
+
+// 只读行视图：row(y) 返回第 y 行首像素，行内像素连续
+template<typename Format>
+class ConstImageView
+{
+public:
+    using Pixel = typename Format::Pixel;
+
+    explicit ConstImageView(const QImage &image)
+        : m_bits(image.constBits()), m_stride(image.bytesPerLine())
+        , m_width(image.width()), m_height(image.height())
+    {
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    const Pixel *row(int y) const
+    {
+        return reinterpret_cast<const Pixel *>(m_bits + qsizetype(y) * m_stride);
+    }
+    const Pixel *rowEnd(int y) const { return row(y) + m_width; }
+
+private:
+    const uchar *m_bits;
+    qsizetype m_stride;
+    int m_width;
+    int m_height;
+};
+
+// 可写行视图：构造时对图像 detach 一次，之后按行写入不再触发拷贝
+template<typename Format>
+class ImageView
+{
+public:
+    using Pixel = typename Format::Pixel;
+
+    explicit ImageView(QImage &image)
+        : m_bits(image.bits()), m_stride(image.bytesPerLine())
+        , m_width(image.width()), m_height(image.height())
+    {
+    }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    Pixel *row(int y) const
+    {
+        return reinterpret_cast<Pixel *>(m_bits + qsizetype(y) * m_stride);
+    }
+    Pixel *rowEnd(int y) const { return row(y) + m_width; }
+
+private:
+    uchar *m_bits;
+    qsizetype m_stride;
+    int m_width;
+    int m_height;
+};
+
+using ConstRgb32View = ConstImageView<Rgb32>;
+using Rgb32View = ImageView<Rgb32>;
+using ConstGray8View = ConstImageView<Gray8>;
+using Gray8View = ImageView<Gray8>;
+
+// 转换为32位处理格式：带透明通道的转为非预乘 ARGB32，否则转为 RGB32
+// 已是目标格式时只做浅拷贝（隐式共享），不复制像素
+inline QImage toRgb32(const QImage &image)
+{
+    const QImage::Format target = image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                          : QImage::Format_RGB32;
+    if (image.format() == target) {
+        return image;
+    }
+    return image.convertToFormat(target);
+}
+
+inline bool isGray8(const QImage &image)
+{
+    return image.format() == QImage::Format_Grayscale8;
+}
+
+// 规范处理格式：灰度图为 Grayscale8，带透明通道为 ARGB32，其余为 RGB32
+// 只按格式和调色板判断灰度（8位及以下的调色板图、16位灰度），不逐像素扫描
+inline QImage::Format canonicalFormat(const QImage &image)
+{
+    const bool gray = image.format() == QImage::Format_Grayscale8
+                      || image.format() == QImage::Format_Grayscale16
+                      || (image.depth() <= 8 && !image.hasAlphaChannel() && image.isGrayscale());
+    if (gray) {
+        return QImage::Format_Grayscale8;
+    }
+    return image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+}
+
+// 加载时统一转换一次为规范格式，之后各命令不再逐次转换格式
+// 已是规范格式时只做浅拷贝（隐式共享），不复制像素
+inline QImage toCanonical(const QImage &image)
+{
+    if (image.isNull()) {
+        return image;
+    }
+    const QImage::Format target = canonicalFormat(image);
+    if (image.format() == target) {
+        return image;
+    }
+    return image.convertToFormat(target);
+}
+
+// 与原 (R+G+B)/3 灰度公式保持一致
+inline int grayOf(QRgb pixel)
+{
+    return (qRed(pixel) + qGreen(pixel) + qBlue(pixel)) / 3;
+}
+
+} // namespace PixelView
+
+#endif // PIXELVIEW_H
@@ -0,0 +1,141 @@
+#include "planarimage.h"
+#include "pixelview.h"
+#include "tilescheduler.h"
+#include <cstring>
+
+namespace {
+
+qsizetype alignUp(qsizetype value, qsizetype alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+PlanarImage::PlanarImage(int width, int height, int planeCount, int halo)
+    : m_width(width), m_height(height), m_planeCount(planeCount), m_halo(halo)
+{
+    if (width <= 0 || height <= 0 || planeCount <= 0) {
+        m_planeCount = 0;
+        return;
+    }
+
+    // 行布局：[左边框（补齐到对齐边界）| width 像素 | 右边框 + Padding]，stride 为对齐的整数倍
+    const qsizetype leftBytes = alignUp(halo, Alignment);
+    m_stride = alignUp(leftBytes + width + halo + Padding, Alignment);
+    m_planeBytes = m_stride * (height + 2 * halo);
+
+    const qsizetype total = m_planeBytes * planeCount + Alignment;
+    m_storage.reset(new uchar[size_t(total)]);
+    const quintptr base = alignUp(qsizetype(quintptr(m_storage.get())), Alignment);
+    m_origin = reinterpret_cast<uchar *>(base) + leftBytes + qsizetype(halo) * m_stride;
+}
+
+PlanarImage PlanarImage::fromImage(const QImage &image, int halo)
+{
+    if (image.isNull()) return PlanarImage();
+
+    if (PixelView::isGray8(image)) {
+        PlanarImage planar(image.width(), image.height(), 1, halo);
+        const PixelView::ConstGray8View src(image);
+        TileScheduler::forEachBand(image.height(), image.bytesPerLine(), 0, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                std::memcpy(planar.row(0, y), src.row(y), size_t(image.width()));
+            }
+        });
+        return planar;
+    }
+
+    const QImage source = PixelView::toRgb32(image);
+    const bool alpha = source.hasAlphaChannel();
+    PlanarImage planar(source.width(), source.height(), alpha ? 4 : 3, halo);
+    const PixelView::ConstRgb32View src(source);
+    const int width = source.width();
+    TileScheduler::forEachBand(source.height(), source.bytesPerLine(), 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const QRgb *in = src.row(y);
+            uchar *r = planar.row(0, y);
+            uchar *g = planar.row(1, y);
+            uchar *b = planar.row(2, y);
+            for (int x = 0; x < width; ++x) {
+                r[x] = uchar(qRed(in[x]));
+                g[x] = uchar(qGreen(in[x]));
+                b[x] = uchar(qBlue(in[x]));
+            }
+            if (alpha) {
+                uchar *a = planar.row(3, y);
+                for (int x = 0; x < width; ++x) {
+                    a[x] = uchar(qAlpha(in[x]));
+                }
+            }
+        }
+    });
+    return planar;
+}
+
+QImage PlanarImage::toImage(QImage target) const
+{
+    if (isNull()) return QImage();
+
+    const QImage::Format format = m_planeCount == 1   ? QImage::Format_Grayscale8
+                                  : m_planeCount == 4 ? QImage::Format_ARGB32
+                                                      : QImage::Format_RGB32;
+    if (target.size() != QSize(m_width, m_height) || target.format() != format) {
+        target = QImage(m_width, m_height, format);
+    }
+
+    if (m_planeCount == 1) {
+        QImage image = std::move(target);
+        const PixelView::Gray8View dst(image);
+        TileScheduler::forEachBand(m_height, m_width, 0, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                std::memcpy(dst.row(y), row(0, y), size_t(m_width));
+            }
+        });
+        return image;
+    }
+
+    QImage image = std::move(target);
+    const PixelView::Rgb32View dst(image);
+    TileScheduler::forEachBand(m_height, image.bytesPerLine(), 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const uchar *r = row(0, y);
+            const uchar *g = row(1, y);
+            const uchar *b = row(2, y);
+            QRgb *out = dst.row(y);
+            for (int x = 0; x < m_width; ++x) {
+                out[x] = 0xff000000u | (uint(r[x]) << 16) | (uint(g[x]) << 8) | b[x];
+            }
+            if (m_planeCount == 4) {
+                const uchar *a = row(3, y);
+                for (int x = 0; x < m_width; ++x) {
+                    out[x] = (out[x] & 0x00ffffffu) | (uint(a[x]) << 24);
+                }
+            }
+        }
+    });
+    return image;
+}
+
+void PlanarImage::fillHalo(BoxFilter::BorderMode mode)
+{
+    if (isNull() || m_halo == 0) return;
+
+    for (int plane = 0; plane < m_planeCount; ++plane) {
+        // 先填左右边框，再整行复制上下边框（边框的角随之填好）
+        for (int y = 0; y < m_height; ++y) {
+            uchar *line = row(plane, y);
+            for (int i = 1; i <= m_halo; ++i) {
+                line[-i] = line[BoxFilter::mapCoordinate(-i, m_width, mode)];
+                line[m_width - 1 + i] = line[BoxFilter::mapCoordinate(m_width - 1 + i, m_width, mode)];
+            }
+        }
+        for (int i = 1; i <= m_halo; ++i) {
+            std::memcpy(row(plane, -i) - m_halo, row(plane, BoxFilter::mapCoordinate(-i, m_height, mode)) - m_halo,
+                        size_t(m_width + 2 * m_halo));
+            std::memcpy(row(plane, m_height - 1 + i) - m_halo,
+                        row(plane, BoxFilter::mapCoordinate(m_height - 1 + i, m_height, mode)) - m_halo,
+                        size_t(m_width + 2 * m_halo));
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PLANARIMAGE_H
+#define PLANARIMAGE_H
+
+#include <QImage>
+#include <QList>
+#include <memory>
+#include "boxfilter.h"
+
+// 平面（SoA）图像缓冲：每个通道单独一个8位平面，供邻域运算在连续的单通道行上执行
+// 每个平面四周留 halo 像素的边框（由 fillHalo 按边界方式填充），内核读取邻域时无需边界判断；
+// 行首（x = 0）按 Alignment 字节对齐，行尾另留 Padding 字节，向量化循环可整块读写越过行宽
+// 32位图像拆为 R/G/B 三个平面，带透明度的图像另加 A 平面（与颜色通道一样参与邻域运算），灰度图为一个平面
+class PlanarImage
+{
+public:
+    static constexpr int Alignment = 64;
+    static constexpr int Padding = 64;
+
+    PlanarImage() = default;
+    PlanarImage(int width, int height, int planeCount, int halo = 0);
+
+    // 从 QImage 拆分（灰度图一个平面，其余转换为 RGB32/ARGB32 后拆为 R/G/B[/A]）
+    static PlanarImage fromImage(const QImage &image, int halo = 0);
+    // 合并为 QImage：一个平面输出 Grayscale8，三个平面输出 RGB32，四个平面输出 ARGB32
+    // target 为调用者预先分配的输出缓冲（须为唯一引用），尺寸或格式不符时忽略并新分配
+    QImage toImage(QImage target = QImage()) const;
+
+    bool isNull() const { return m_planeCount == 0; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int planeCount() const { return m_planeCount; }
+    int halo() const { return m_halo; }
+    qsizetype stride() const { return m_stride; }
+
+    // 第 plane 个平面第 y 行 x = 0 处的指针；y 可取 [-halo, height + halo)，行内可访问 [-halo, width + halo)
+    uchar *row(int plane, int y) { return m_origin + plane * m_planeBytes + qsizetype(y) * m_stride; }
+    const uchar *row(int plane, int y) const { return m_origin + plane * m_planeBytes + qsizetype(y) * m_stride; }
+
+    // 按边界方式填充各平面的 halo 边框
+    void fillHalo(BoxFilter::BorderMode mode);
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_planeCount = 0;
+    int m_halo = 0;
+    qsizetype m_stride = 0;
+    qsizetype m_planeBytes = 0;
+    std::shared_ptr<uchar[]> m_storage;
+    uchar *m_origin = nullptr;      // 第0个平面 (0, 0) 像素
+};
+
+#endif // PLANARIMAGE_H
@@ -0,0 +1,389 @@
+#include "pointkernels.h"
+#include <QByteArray>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define POINTKERNELS_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define POINTKERNELS_TARGET_AVX2
+#  else
+#    include <cpuid.h>
+#    define POINTKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+namespace {
+
+// 整数除以3：对 0~765 范围内的和，(sum * 0xAAAB) >> 17 与 sum / 3 完全一致
+inline int divideBy3(int sum)
+{
+    return (sum * 0xAAAB) >> 17;
+}
+
+inline int grayOf(QRgb pixel)
+{
+    return divideBy3(qRed(pixel) + qGreen(pixel) + qBlue(pixel));
+}
+
+// ========== 标量实现 ==========
+void grayRgb32Scalar(const QRgb *src, QRgb *dst, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const int gray = grayOf(src[i]);
+        dst[i] = qRgb(gray, gray, gray);
+    }
+}
+
+void grayRgb32ToGray8Scalar(const QRgb *src, uchar *dst, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        dst[i] = uchar(grayOf(src[i]));
+    }
+}
+
+void thresholdRgb32Scalar(const QRgb *src, QRgb *dst, int count, int threshold)
+{
+    for (int i = 0; i < count; ++i) {
+        dst[i] = grayOf(src[i]) > threshold ? 0xffffffffu : 0xff000000u;
+    }
+}
+
+void lookupRgb32Scalar(const QRgb *src, QRgb *dst, int count, const qint32 *table)
+{
+    for (int i = 0; i < count; ++i) {
+        const QRgb pixel = src[i];
+        dst[i] = qRgb(table[qRed(pixel)], table[qGreen(pixel)], table[qBlue(pixel)]);
+    }
+}
+
+void thresholdGray8Scalar(const uchar *src, uchar *dst, int count, int threshold)
+{
+    for (int i = 0; i < count; ++i) {
+        dst[i] = src[i] > threshold ? 255 : 0;
+    }
+}
+
+// 阈值超出 0~254 时结果与输入无关
+bool thresholdGray8Trivial(uchar *dst, int count, int threshold)
+{
+    if (threshold < 0) {
+        std::memset(dst, 255, size_t(count));
+        return true;
+    }
+    if (threshold >= 255) {
+        std::memset(dst, 0, size_t(count));
+        return true;
+    }
+    return false;
+}
+
+#ifdef POINTKERNELS_X86
+
+// ========== SSE2 实现（x86-64 基线指令集，无需运行时检测） ==========
+
+// 4个像素的 R+G+B（32位通道）
+inline __m128i channelSum4(__m128i pixels)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i b = _mm_and_si128(pixels, mask);
+    const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+    const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+    return _mm_add_epi32(_mm_add_epi32(r, g), b);
+}
+
+// 8个像素的灰度值（16位通道）
+inline __m128i gray8Pixels(const QRgb *src)
+{
+    const __m128i lo = channelSum4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+    const __m128i hi = channelSum4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4)));
+    const __m128i sum = _mm_packs_epi32(lo, hi);
+    return _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16(short(0xAAAB))), 1);
+}
+
+// 32位灰度值扩展为不透明灰度像素
+inline __m128i grayToRgb32(__m128i gray)
+{
+    return _mm_or_si128(_mm_or_si128(gray, _mm_slli_epi32(gray, 8)),
+                        _mm_or_si128(_mm_slli_epi32(gray, 16), _mm_set1_epi32(int(0xff000000u))));
+}
+
+void grayRgb32Sse2(const QRgb *src, QRgb *dst, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i gray = gray8Pixels(src + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), grayToRgb32(_mm_unpacklo_epi16(gray, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), grayToRgb32(_mm_unpackhi_epi16(gray, zero)));
+    }
+    grayRgb32Scalar(src + i, dst + i, count - i);
+}
+
+void grayRgb32ToGray8Sse2(const QRgb *src, uchar *dst, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i gray = _mm_packus_epi16(gray8Pixels(src + i), gray8Pixels(src + i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), gray);
+    }
+    grayRgb32ToGray8Scalar(src + i, dst + i, count - i);
+}
+
+void thresholdRgb32Sse2(const QRgb *src, QRgb *dst, int count, int threshold)
+{
+    const __m128i limit = _mm_set1_epi16(short(qBound(-1, threshold, 765)));
+    const __m128i black = _mm_set1_epi32(int(0xff000000u));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i mask = _mm_cmpgt_epi16(gray8Pixels(src + i), limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(_mm_unpacklo_epi16(mask, mask), black));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_or_si128(_mm_unpackhi_epi16(mask, mask), black));
+    }
+    thresholdRgb32Scalar(src + i, dst + i, count - i, threshold);
+}
+
+// 无符号字节比较：两边同时异或 0x80 后按有符号比较
+void thresholdGray8Sse2(const uchar *src, uchar *dst, int count, int threshold)
+{
+    if (thresholdGray8Trivial(dst, count, threshold)) return;
+    const __m128i bias = _mm_set1_epi8(char(0x80));
+    const __m128i limit = _mm_set1_epi8(char(threshold ^ 0x80));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i pixels = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_cmpgt_epi8(pixels, limit));
+    }
+    thresholdGray8Scalar(src + i, dst + i, count - i, threshold);
+}
+
+// SSE2 没有 gather 指令，查找表沿用标量实现（按4像素展开）
+void lookupRgb32Sse2(const QRgb *src, QRgb *dst, int count, const qint32 *table)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const QRgb p0 = src[i], p1 = src[i + 1], p2 = src[i + 2], p3 = src[i + 3];
+        dst[i] = qRgb(table[qRed(p0)], table[qGreen(p0)], table[qBlue(p0)]);
+        dst[i + 1] = qRgb(table[qRed(p1)], table[qGreen(p1)], table[qBlue(p1)]);
+        dst[i + 2] = qRgb(table[qRed(p2)], table[qGreen(p2)], table[qBlue(p2)]);
+        dst[i + 3] = qRgb(table[qRed(p3)], table[qGreen(p3)], table[qBlue(p3)]);
+    }
+    lookupRgb32Scalar(src + i, dst + i, count - i, table);
+}
+
+// ========== AVX2 实现（运行时检测后启用） ==========
+
+POINTKERNELS_TARGET_AVX2 inline __m256i channelSum8(__m256i pixels)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i b = _mm256_and_si256(pixels, mask);
+    const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask);
+    const __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask);
+    return _mm256_add_epi32(_mm256_add_epi32(r, g), b);
+}
+
+// 16个像素的灰度值（16位通道）
+// 注意 packs 按128位通道交错：结果顺序为 [0-3, 8-11 | 4-7, 12-15]
+POINTKERNELS_TARGET_AVX2 inline __m256i gray16Pixels(const QRgb *src)
+{
+    const __m256i lo = channelSum8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+    const __m256i hi = channelSum8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 8)));
+    const __m256i sum = _mm256_packs_epi32(lo, hi);
+    return _mm256_srli_epi16(_mm256_mulhi_epu16(sum, _mm256_set1_epi16(short(0xAAAB))), 1);
+}
+
+POINTKERNELS_TARGET_AVX2 inline __m256i grayToRgb32Avx2(__m256i gray)
+{
+    return _mm256_or_si256(_mm256_or_si256(gray, _mm256_slli_epi32(gray, 8)),
+                           _mm256_or_si256(_mm256_slli_epi32(gray, 16), _mm256_set1_epi32(int(0xff000000u))));
+}
+
+// unpacklo/unpackhi 同样按128位通道工作，恰好还原 packs 的交错顺序
+POINTKERNELS_TARGET_AVX2 void grayRgb32Avx2(const QRgb *src, QRgb *dst, int count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i gray = gray16Pixels(src + i);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), grayToRgb32Avx2(_mm256_unpacklo_epi16(gray, zero)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8), grayToRgb32Avx2(_mm256_unpackhi_epi16(gray, zero)));
+    }
+    grayRgb32Sse2(src + i, dst + i, count - i);
+}
+
+POINTKERNELS_TARGET_AVX2 void grayRgb32ToGray8Avx2(const QRgb *src, uchar *dst, int count)
+{
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        // 两次交错后的字节顺序为 [0-3,8-11,16-19,24-27 | 4-7,12-15,20-23,28-31]（每组4字节）
+        const __m256i packed = _mm256_packus_epi16(gray16Pixels(src + i), gray16Pixels(src + i + 16));
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    grayRgb32ToGray8Sse2(src + i, dst + i, count - i);
+}
+
+POINTKERNELS_TARGET_AVX2 void thresholdRgb32Avx2(const QRgb *src, QRgb *dst, int count, int threshold)
+{
+    const __m256i limit = _mm256_set1_epi16(short(qBound(-1, threshold, 765)));
+    const __m256i black = _mm256_set1_epi32(int(0xff000000u));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i mask = _mm256_cmpgt_epi16(gray16Pixels(src + i), limit);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(_mm256_unpacklo_epi16(mask, mask), black));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8), _mm256_or_si256(_mm256_unpackhi_epi16(mask, mask), black));
+    }
+    thresholdRgb32Sse2(src + i, dst + i, count - i, threshold);
+}
+
+// 查找表已由 widen() 展开为32位表项，可直接作为 gather 的基址
+POINTKERNELS_TARGET_AVX2 void lookupRgb32Avx2(const QRgb *src, QRgb *dst, int count, const qint32 *table)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000u));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const __m256i b = _mm256_i32gather_epi32(table, _mm256_and_si256(pixels, mask), 4);
+        const __m256i g = _mm256_i32gather_epi32(table, _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask), 4);
+        const __m256i r = _mm256_i32gather_epi32(table, _mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask), 4);
+        const __m256i out = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)),
+                                            _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+    }
+    lookupRgb32Scalar(src + i, dst + i, count - i, table);
+}
+
+POINTKERNELS_TARGET_AVX2 void thresholdGray8Avx2(const uchar *src, uchar *dst, int count, int threshold)
+{
+    if (thresholdGray8Trivial(dst, count, threshold)) return;
+    const __m256i bias = _mm256_set1_epi8(char(0x80));
+    const __m256i limit = _mm256_set1_epi8(char(threshold ^ 0x80));
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i pixels = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)), bias);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_cmpgt_epi8(pixels, limit));
+    }
+    thresholdGray8Sse2(src + i, dst + i, count - i, threshold);
+}
+
+// 检测 CPU 与操作系统是否都支持 AVX2（操作系统需保存 YMM 寄存器状态）
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // POINTKERNELS_X86
+
+// 运行时选择的内核表
+struct KernelTable
+{
+    const char *name;
+    void (*gray)(const QRgb *, QRgb *, int);
+    void (*grayToGray8)(const QRgb *, uchar *, int);
+    void (*threshold)(const QRgb *, QRgb *, int, int);
+    void (*lookup)(const QRgb *, QRgb *, int, const qint32 *);
+    void (*thresholdGray8)(const uchar *, uchar *, int, int);
+};
+
+KernelTable selectKernels()
+{
+    const KernelTable scalar = { "scalar", grayRgb32Scalar, grayRgb32ToGray8Scalar,
+                                 thresholdRgb32Scalar, lookupRgb32Scalar, thresholdGray8Scalar };
+#ifdef POINTKERNELS_X86
+    const KernelTable sse2 = { "sse2", grayRgb32Sse2, grayRgb32ToGray8Sse2,
+                               thresholdRgb32Sse2, lookupRgb32Sse2, thresholdGray8Sse2 };
+    const KernelTable avx2 = { "avx2", grayRgb32Avx2, grayRgb32ToGray8Avx2,
+                               thresholdRgb32Avx2, lookupRgb32Avx2, thresholdGray8Avx2 };
+
+    // 环境变量 PSVIDIO_SIMD=scalar|sse2 可强制降级，便于对比测试
+    const QByteArray forced = qgetenv("PSVIDIO_SIMD");
+    if (forced == "scalar") return scalar;
+    if (forced == "sse2") return sse2;
+    return cpuHasAvx2() ? avx2 : sse2;
+#else
+    return scalar;
+#endif
+}
+
+const KernelTable &kernels()
+{
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+} // namespace
+
+namespace PointKernels {
+
+void grayRgb32(const QRgb *src, QRgb *dst, int count)
+{
+    kernels().gray(src, dst, count);
+}
+
+void grayRgb32ToGray8(const QRgb *src, uchar *dst, int count)
+{
+    kernels().grayToGray8(src, dst, count);
+}
+
+void thresholdRgb32(const QRgb *src, QRgb *dst, int count, int threshold)
+{
+    kernels().threshold(src, dst, count, threshold);
+}
+
+WideTable widen(const uchar *table)
+{
+    WideTable wide;
+    for (int i = 0; i < 256; ++i) {
+        wide[i] = table[i];
+    }
+    return wide;
+}
+
+void lookupRgb32(const QRgb *src, QRgb *dst, int count, const WideTable &table)
+{
+    kernels().lookup(src, dst, count, table.data());
+}
+
+void thresholdGray8(const uchar *src, uchar *dst, int count, int threshold)
+{
+    kernels().thresholdGray8(src, dst, count, threshold);
+}
+
+// 8位查找表没有可用的字节 gather 指令，标量实现（按4像素展开）
+void lookupGray8(const uchar *src, uchar *dst, int count, const uchar *table)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uchar v0 = table[src[i]], v1 = table[src[i + 1]], v2 = table[src[i + 2]], v3 = table[src[i + 3]];
+        dst[i] = v0;
+        dst[i + 1] = v1;
+        dst[i + 2] = v2;
+        dst[i + 3] = v3;
+    }
+    for (; i < count; ++i) {
+        dst[i] = table[src[i]];
+    }
+}
+
+const char *activeInstructionSet()
+{
+    return kernels().name;
+}
+
+} // namespace PointKernels
@@ -0,0 +1,36 @@
+#ifndef POINTKERNELS_H
+#define POINTKERNELS_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <array>
+
+// 点运算行内核（灰度化 / 阈值 / 8位查找表）
+// 提供标量、SSE2、AVX2 三套实现，首次调用时根据 cpuid 选择，同一可执行文件可在所有机器上运行
+// 输入输出为 Format_RGB32 / Format_ARGB32 行（输出像素的透明度固定为255），
+// 或 Format_Grayscale8 行（*Gray8 内核，可原地执行）
+namespace PointKernels {
+
+// 灰度化：(R+G+B)/3，灰度值复制到三个通道
+void grayRgb32(const QRgb *src, QRgb *dst, int count);
+// 灰度化并输出单字节灰度（Format_Grayscale8 行）
+void grayRgb32ToGray8(const QRgb *src, uchar *dst, int count);
+// 二值化：灰度值大于阈值为白色，否则为黑色
+void thresholdRgb32(const QRgb *src, QRgb *dst, int count, int threshold);
+// 展开为32位表项的查找表（值仍为 0~255）：AVX2 的 gather 以32位为单位读取，
+// 由 widen() 每张表展开一次，之后各行直接使用
+using WideTable = std::array<qint32, 256>;
+WideTable widen(const uchar *table);
+// 对 R/G/B 三个通道使用同一张256项查找表
+void lookupRgb32(const QRgb *src, QRgb *dst, int count, const WideTable &table);
+// 灰度行二值化：大于阈值为255，否则为0
+void thresholdGray8(const uchar *src, uchar *dst, int count, int threshold);
+// 灰度行查找表
+void lookupGray8(const uchar *src, uchar *dst, int count, const uchar *table);
+
+// 当前选用的指令集名称（"avx2" / "sse2" / "scalar"），用于日志和基准测试
+const char *activeInstructionSet();
+
+} // namespace PointKernels
+
+#endif // POINTKERNELS_H
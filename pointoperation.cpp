@@ -0,0 +1,284 @@
+#include "pointoperation.h"
+#include "pixelview.h"
+#include "pointkernels.h"
+#include "tilescheduler.h"
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+PointOperation::LookupTable identityTable()
+{
+    PointOperation::LookupTable table;
+    for (int i = 0; i < 256; ++i) {
+        table[i] = uchar(i);
+    }
+    return table;
+}
+
+// 表复合：先查 first，再查 second
+PointOperation::LookupTable compose(const PointOperation::LookupTable &first,
+                                    const PointOperation::LookupTable &second)
+{
+    PointOperation::LookupTable table;
+    for (int i = 0; i < 256; ++i) {
+        table[i] = second[first[i]];
+    }
+    return table;
+}
+
+// 表为阈值阶跃函数（i > threshold ? 255 : 0）时返回阈值（-1~255），否则返回 -2
+int thresholdOf(const PointOperation::LookupTable &table)
+{
+    int threshold = -1;
+    while (threshold < 255 && table[threshold + 1] == 0) {
+        ++threshold;
+    }
+    for (int i = threshold + 1; i < 256; ++i) {
+        if (table[i] != 255) return -2;
+    }
+    return threshold;
+}
+
+} // namespace
+
+PointOperation::PointOperation()
+    : m_pre(identityTable()), m_post(identityTable())
+{
+    updateShortcuts();
+}
+
+PointOperation PointOperation::grayscale()
+{
+    PointOperation op;
+    op.m_reduce = true;
+    op.updateShortcuts();
+    return op;
+}
+
+PointOperation PointOperation::threshold(int threshold)
+{
+    PointOperation op;
+    op.m_reduce = true;
+    for (int i = 0; i < 256; ++i) {
+        op.m_post[i] = i > threshold ? 255 : 0;
+    }
+    op.updateShortcuts();
+    return op;
+}
+
+PointOperation PointOperation::gamma(double gamma)
+{
+    return lookup(gammaTable(gamma));
+}
+
+PointOperation PointOperation::lookup(const LookupTable &table)
+{
+    PointOperation op;
+    op.m_pre = table;
+    op.updateShortcuts();
+    return op;
+}
+
+PointOperation PointOperation::then(const PointOperation &next) const
+{
+    PointOperation op;
+    if (!m_reduce && !next.m_reduce) {
+        // 两个逐通道运算：pre 表直接复合
+        op.m_pre = compose(m_pre, next.m_pre);
+    } else if (!m_reduce) {
+        // 逐通道运算之后归约：并入 next 的 pre 表
+        op.m_reduce = true;
+        op.m_pre = compose(m_pre, next.m_pre);
+        op.m_post = next.m_post;
+    } else {
+        // 归约之后三个通道相等，(v+v+v)/3 == v，next 的 pre/post 都可并入 post 表
+        op.m_reduce = true;
+        op.m_pre = m_pre;
+        op.m_post = compose(compose(m_post, next.m_pre), next.m_post);
+    }
+    op.updateShortcuts();
+    return op;
+}
+
+bool PointOperation::isIdentity() const
+{
+    return !m_reduce && m_preIdentity;
+}
+
+bool PointOperation::reducesToGray() const
+{
+    return m_reduce;
+}
+
+bool PointOperation::readsGrayOnly() const
+{
+    return m_reduce && m_preIdentity;
+}
+
+void PointOperation::updateShortcuts()
+{
+    const LookupTable identity = identityTable();
+    m_preIdentity = (m_pre == identity);
+    m_preWide = PointKernels::widen(m_pre.data());
+    m_postIdentity = (m_post == identity);
+
+    // 识别 post 表是否为阈值阶跃函数（i > threshold ? 255 : 0）
+    m_postThreshold = thresholdOf(m_post);
+}
+
+void PointOperation::applyRow(const QRgb *src, QRgb *dst, int count) const
+{
+    if (!m_reduce) {
+        PointKernels::lookupRgb32(src, dst, count, m_preWide);
+        return;
+    }
+
+    // 常见情况直接使用专用内核
+    if (m_preIdentity && m_postIdentity) {
+        PointKernels::grayRgb32(src, dst, count);
+        return;
+    }
+    if (m_preIdentity && m_postThreshold >= -1) {
+        PointKernels::thresholdRgb32(src, dst, count, m_postThreshold);
+        return;
+    }
+
+    // 一般情况：分块处理，灰度中间结果留在栈上的小缓冲区中（仍是单遍访问图像内存）
+    uchar gray[256];
+    for (int offset = 0; offset < count; offset += 256) {
+        const int n = qMin(256, count - offset);
+        const QRgb *in = src + offset;
+        QRgb *out = dst + offset;
+        if (!m_preIdentity) {
+            PointKernels::lookupRgb32(in, out, n, m_preWide);
+            in = out;
+        }
+        PointKernels::grayRgb32ToGray8(in, gray, n);
+        for (int i = 0; i < n; ++i) {
+            out[i] = 0xff000000u | (uint(m_post[gray[i]]) * 0x010101u);
+        }
+    }
+}
+
+void PointOperation::applyRowToGray8(const QRgb *src, uchar *dst, int count) const
+{
+    if (m_preIdentity) {
+        PointKernels::grayRgb32ToGray8(src, dst, count);
+    } else {
+        QRgb mapped[256];
+        for (int offset = 0; offset < count; offset += 256) {
+            const int n = qMin(256, count - offset);
+            PointKernels::lookupRgb32(src + offset, mapped, n, m_preWide);
+            PointKernels::grayRgb32ToGray8(mapped, dst + offset, n);
+        }
+    }
+
+    if (m_postThreshold >= -1) {
+        PointKernels::thresholdGray8(dst, dst, count, m_postThreshold);
+    } else if (!m_postIdentity) {
+        PointKernels::lookupGray8(dst, dst, count, m_post.data());
+    }
+}
+
+PointOperation::LookupTable PointOperation::grayTable() const
+{
+    return m_reduce ? compose(m_pre, m_post) : m_pre;
+}
+
+QImage::Format PointOperation::resultFormat(const QImage &image) const
+{
+    if (PixelView::isGray8(image) || m_reduce) {
+        return QImage::Format_Grayscale8;
+    }
+    return image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+}
+
+QImage PointOperation::apply(const QImage &image, QImage target) const
+{
+    if (isIdentity()) {
+        return image;
+    }
+    // 预分配的缓冲区移入结果，保持唯一引用，写入时不会触发隐式共享的复制
+    if (target.size() != image.size() || target.format() != resultFormat(image)) {
+        target = QImage();
+    }
+
+    // 灰度输入：整个运算化为一张查找表（灰度化本身即恒等），输出仍为灰度
+    if (PixelView::isGray8(image)) {
+        const LookupTable table = grayTable();
+        if (table == identityTable()) {
+            return image;
+        }
+
+        QImage resultImage = target.isNull() ? QImage(image.size(), QImage::Format_Grayscale8) : std::move(target);
+        const PixelView::ConstGray8View src(image);
+        const PixelView::Gray8View dst(resultImage);
+        const int threshold = thresholdOf(table);
+
+        TileScheduler::forEachBand(src.height(), image.bytesPerLine(), 0, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                if (threshold >= -1) {
+                    PointKernels::thresholdGray8(src.row(y), dst.row(y), src.width(), threshold);
+                } else {
+                    PointKernels::lookupGray8(src.row(y), dst.row(y), src.width(), table.data());
+                }
+            }
+        });
+        return resultImage;
+    }
+
+    const QImage source = PixelView::toRgb32(image);
+
+    // 归约为灰度的运算（灰度化、二值化及其融合链）输出单字节灰度，结果只占32位图像的1/4
+    if (m_reduce) {
+        QImage resultImage = target.isNull() ? QImage(source.size(), QImage::Format_Grayscale8) : std::move(target);
+        const PixelView::ConstRgb32View src(source);
+        const PixelView::Gray8View dst(resultImage);
+        TileScheduler::forEachBand(src.height(), source.bytesPerLine(), 0, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                applyRowToGray8(src.row(y), dst.row(y), src.width());
+            }
+        });
+        return resultImage;
+    }
+
+    QImage resultImage = target.isNull() ? QImage(source.size(), source.format()) : std::move(target);
+
+    const PixelView::ConstRgb32View src(source);
+    const PixelView::Rgb32View dst(resultImage);
+    TileScheduler::forEachBand(src.height(), source.bytesPerLine(), 0, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            applyRow(src.row(y), dst.row(y), src.width());
+        }
+    });
+
+    return resultImage;
+}
+
+PointOperation::LookupTable PointOperation::gammaTable(double gamma)
+{
+    static QMutex mutex;
+    static QHash<quint64, LookupTable> cache;
+
+    quint64 key;
+    std::memcpy(&key, &gamma, sizeof(key));
+
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(key);
+    if (it != cache.constEnd()) {
+        return it.value();
+    }
+
+    // 与逐像素公式一致：qRound(pow(v/255, gamma) * 255)，并确保值在0-255范围内
+    LookupTable table;
+    for (int i = 0; i < 256; ++i) {
+        table[i] = uchar(qBound(0, qRound(std::pow(i / 255.0, gamma) * 255), 255));
+    }
+    cache.insert(key, table);
+    return table;
+}
@@ -0,0 +1,60 @@
+#ifndef POINTOPERATION_H
+#define POINTOPERATION_H
+
+#include <QImage>
+#include <QRgb>
+#include <array>
+#include "pointkernels.h"
+
+// 可融合的点运算
+// 统一表示为：各通道先查 pre 表 →（可选）归约为灰度 (R+G+B)/3 → 再查 post 表
+// 灰度化、二值化、伽马变换都能写成这种形式，相邻的点运算可合成为一个，整幅图像只遍历一次
+class PointOperation
+{
+public:
+    using LookupTable = std::array<uchar, 256>;
+
+    PointOperation();  // 恒等运算
+
+    static PointOperation grayscale();
+    static PointOperation threshold(int threshold);
+    static PointOperation gamma(double gamma);
+    static PointOperation lookup(const LookupTable &table);
+
+    // 先执行当前运算，再执行 next，返回等价的单个运算
+    PointOperation then(const PointOperation &next) const;
+
+    bool isIdentity() const;
+    bool reducesToGray() const;
+    // 先归约为灰度（pre 表为恒等）：结果只取决于输入的灰度，灰度图（如视频帧的亮度平面）可直接作为输入
+    bool readsGrayOnly() const;
+
+    // 对整幅图像单遍执行，输出透明度为255
+    // 灰度输入或归约为灰度的运算输出 Format_Grayscale8，其余输出32位处理格式
+    // target 为调用者预先分配的输出缓冲（如 FramePool 的缓冲区，须为唯一引用），
+    // 尺寸与格式不符 resultFormat() 时忽略并新分配；运算为恒等时直接返回输入
+    QImage apply(const QImage &image, QImage target = QImage()) const;
+    QImage::Format resultFormat(const QImage &image) const;
+    // 对一行32位像素执行
+    void applyRow(const QRgb *src, QRgb *dst, int count) const;
+    // 对一行32位像素执行并输出灰度（只用于 reducesToGray() 的运算）
+    void applyRowToGray8(const QRgb *src, uchar *dst, int count) const;
+    // 作用于灰度输入时的等价查找表（三个通道相等，归约不改变灰度值）
+    LookupTable grayTable() const;
+
+    // 伽马查找表，每个伽马值只计算一次
+    static LookupTable gammaTable(double gamma);
+
+private:
+    LookupTable m_pre;
+    LookupTable m_post;
+    PointKernels::WideTable m_preWide;  // m_pre 展开为32位表项，供32位行内核直接使用
+    bool m_reduce = false;
+    bool m_preIdentity = true;
+    bool m_postIdentity = true;
+    int m_postThreshold = -2;  // post 表是阈值阶跃函数时的阈值（-1~255），否则为 -2
+
+    void updateShortcuts();
+};
+
+#endif // POINTOPERATION_H
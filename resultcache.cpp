@@ -0,0 +1,78 @@
+#include "resultcache.h"
+#include "imagecommand.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <atomic>
+
+namespace {
+
+// QCache 的代价以 KB 计
+constexpr qsizetype DefaultMaxKBytes = 512 * 1024;
+
+QMutex g_mutex;
+std::atomic<qint64> g_hits { 0 };
+std::atomic<qint64> g_misses { 0 };
+
+QCache<QString, QImage> &cache()
+{
+    static QCache<QString, QImage> results(DefaultMaxKBytes);
+    return results;
+}
+
+} // namespace
+
+QString ResultCache::key(quint64 inputId, const ImageCommand &command)
+{
+    return QString("%1|%2").arg(inputId).arg(command.cacheKey());
+}
+
+bool ResultCache::lookup(const QString &key, QImage *result)
+{
+    QMutexLocker locker(&g_mutex);
+    const QImage *cached = cache().object(key);  // 命中时移到最近使用
+    if (!cached) {
+        ++g_misses;
+        return false;
+    }
+    ++g_hits;
+    *result = *cached;
+    return true;
+}
+
+void ResultCache::insert(const QString &key, const QImage &result)
+{
+    if (result.isNull()) return;
+
+    // 图像隐式共享，缓存只增加引用计数；超过容量的结果不缓存
+    QMutexLocker locker(&g_mutex);
+    cache().insert(key, new QImage(result), result.sizeInBytes() / 1024 + 1);
+}
+
+void ResultCache::clear()
+{
+    QMutexLocker locker(&g_mutex);
+    cache().clear();
+}
+
+void ResultCache::setMaxBytes(qsizetype bytes)
+{
+    QMutexLocker locker(&g_mutex);
+    cache().setMaxCost(qMax<qsizetype>(0, bytes / 1024));
+}
+
+qsizetype ResultCache::maxBytes()
+{
+    QMutexLocker locker(&g_mutex);
+    return cache().maxCost() * 1024;
+}
+
+qint64 ResultCache::hits()
+{
+    return g_hits.load();
+}
+
+qint64 ResultCache::misses()
+{
+    return g_misses.load();
+}
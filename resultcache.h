@@ -0,0 +1,31 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QImage>
+#include <QString>
+
+class ImageCommand;
+
+// 命令结果的 LRU 缓存（所有文档共享，按图像字节数限制总大小）
+// 键由输入图像的标识（如历史快照编号）和命令标识（名称+参数）组成，
+// 重做、在历史中来回切换、滑块拖回原值时可直接取用之前的结果
+class ResultCache
+{
+public:
+    static QString key(quint64 inputId, const ImageCommand &command);
+
+    // 命中时写入 result 并返回 true
+    static bool lookup(const QString &key, QImage *result);
+    static void insert(const QString &key, const QImage &result);
+    static void clear();
+
+    // 缓存容量（默认 512 MB）
+    static void setMaxBytes(qsizetype bytes);
+    static qsizetype maxBytes();
+
+    // 命中/未命中计数
+    static qint64 hits();
+    static qint64 misses();
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,57 @@
+#ifndef TASKCONTROL_H
+#define TASKCONTROL_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// 后台任务的取消标记与进度
+// 执行命令前用 Scope 绑定到当前线程，TileScheduler 在每个行带开始前检查取消、完成后累加进度，
+// 因此各命令的 apply() 无需额外参数即可支持协作式取消
+class TaskControl
+{
+public:
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+    // 开始新的处理阶段（如命令链中的下一步），total 为该阶段的总行数
+    void beginStage(qint64 total)
+    {
+        m_done.store(0, std::memory_order_relaxed);
+        m_total.store(qMax<qint64>(1, total), std::memory_order_relaxed);
+    }
+    void addProgress(qint64 units) { m_done.fetch_add(units, std::memory_order_relaxed); }
+
+    // 当前阶段的完成比例（0.0 ~ 1.0）
+    double progress() const
+    {
+        return qMin(1.0, double(m_done.load(std::memory_order_relaxed))
+                             / double(m_total.load(std::memory_order_relaxed)));
+    }
+
+    // 当前线程绑定的任务控制（未绑定时为 nullptr）
+    static TaskControl *current() { return currentSlot(); }
+
+    class Scope
+    {
+    public:
+        explicit Scope(TaskControl *control) : m_previous(currentSlot()) { currentSlot() = control; }
+        ~Scope() { currentSlot() = m_previous; }
+        Q_DISABLE_COPY(Scope)
+
+    private:
+        TaskControl *m_previous;
+    };
+
+private:
+    static TaskControl *&currentSlot()
+    {
+        static thread_local TaskControl *control = nullptr;
+        return control;
+    }
+
+    std::atomic<bool> m_cancelled { false };
+    std::atomic<qint64> m_done { 0 };
+    std::atomic<qint64> m_total { 1 };
+};
+
+#endif // TASKCONTROL_H
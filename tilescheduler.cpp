@@ -0,0 +1,105 @@
+#include "tilescheduler.h"
+#include "taskcontrol.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <atomic>
+
+namespace {
+
+// 每个行带的目标数据量（约为一级/二级缓存大小）
+constexpr qsizetype BandBytes = 256 * 1024;
+// 行带的最小行数，避免调度开销超过计算量
+constexpr int MinBandRows = 16;
+// 邻域运算的每个行带需额外读取并预热 2*halo+1 行，行带至少为 halo 的32倍时这部分开销约为6%
+constexpr int HaloBandFactor = 32;
+
+std::atomic<int> g_maxThreads { 0 };
+
+// 专用线程池：其中的任务只计算行带、从不阻塞等待，
+// 因此从其他线程池（批处理、视频）中嵌套调用也不会死锁
+QThreadPool *tilePool()
+{
+    static QThreadPool *pool = [] {
+        QThreadPool *p = new QThreadPool;
+        p->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return p;
+    }();
+    return pool;
+}
+
+} // namespace
+
+void TileScheduler::setMaxThreads(int threads)
+{
+    g_maxThreads = qMax(1, threads);
+    // 调用线程之外还需要 threads-1 个工作线程
+    if (tilePool()->maxThreadCount() < threads - 1) {
+        tilePool()->setMaxThreadCount(threads - 1);
+    }
+}
+
+int TileScheduler::maxThreads()
+{
+    const int threads = g_maxThreads.load();
+    return threads > 0 ? threads : qMax(1, QThread::idealThreadCount());
+}
+
+void TileScheduler::forEachBand(int height, qsizetype bytesPerRow, int halo, const BandFunction &work)
+{
+    forEachBandPerWorker(height, bytesPerRow, halo, [&work]() { return work; });
+}
+
+void TileScheduler::forEachBandPerWorker(int height, qsizetype bytesPerRow, int halo, const WorkerFactory &makeWorker)
+{
+    if (height <= 0) return;
+
+    // 后台执行时检查取消并汇报进度（调用线程上绑定的任务控制）
+    TaskControl *control = TaskControl::current();
+    if (control) {
+        if (control->isCancelled()) return;
+        control->beginStage(height);
+    }
+
+    const int threads = maxThreads();
+
+    // 行带大小：按缓存估算，且随 halo 增大（至少为 halo 的 HaloBandFactor 倍）
+    int bandRows = int(qMax<qsizetype>(1, BandBytes / qMax<qsizetype>(1, bytesPerRow)));
+    bandRows = qMax(bandRows, qMax(MinBandRows, HaloBandFactor * halo));
+    // 行数较少时缩小行带，保证每个线程都有活干
+    bandRows = qMin(bandRows, qMax(1, (height + threads - 1) / threads));
+
+    const int bandCount = (height + bandRows - 1) / bandRows;
+
+    // 各线程从共享计数器领取下一个行带，先做完的线程自动多领，负载自动均衡
+    // 取消在行带粒度上生效：已开始的行带做完，其余行带不再领取
+    std::atomic<int> nextBand { 0 };
+    auto runBands = [&]() {
+        BandFunction work;
+        for (int band = nextBand.fetch_add(1); band < bandCount; band = nextBand.fetch_add(1)) {
+            if (control && control->isCancelled()) return;
+            const int begin = band * bandRows;
+            const int end = qMin(begin + bandRows, height);
+            if (!work) work = makeWorker();
+            work(begin, end);
+            if (control) control->addProgress(end - begin);
+        }
+    };
+
+    if (threads == 1 || bandCount == 1) {
+        runBands();
+        return;
+    }
+
+    const int helpers = qMin(threads, bandCount) - 1;
+    QSemaphore finished;
+    for (int i = 0; i < helpers; ++i) {
+        tilePool()->start([&]() {
+            runBands();
+            finished.release();
+        });
+    }
+
+    runBands();
+    finished.acquire(helpers);
+}
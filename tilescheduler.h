@@ -0,0 +1,28 @@
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+#include <QtGlobal>
+#include <functional>
+
+// 多核分块执行：把图像的行切成适合缓存大小的行带，在专用线程池上并行处理
+// 命令只需把"处理 [begin, end) 行"写成函数即可接入；邻域运算通过 halo 声明需要额外读取的上下行数
+class TileScheduler
+{
+public:
+    using BandFunction = std::function<void(int begin, int end)>;
+
+    // 并行处理 [0, height) 行，调用线程也参与计算，返回时所有行带均已完成
+    // bytesPerRow 用于估算行带大小，halo 为每个行带上下各需读取的邻域行数
+    static void forEachBand(int height, qsizetype bytesPerRow, int halo, const BandFunction &work);
+
+    // 同上，每个参与计算的线程在领取第一个行带时调用一次 makeWorker 得到自己的行带函数，
+    // 之后该线程领取的行带都交给它处理：行带间复用的工作缓冲区（如滑动窗口的环形缓冲区）每个线程只分配一次
+    using WorkerFactory = std::function<BandFunction()>;
+    static void forEachBandPerWorker(int height, qsizetype bytesPerRow, int halo, const WorkerFactory &makeWorker);
+
+    // 最大并行线程数（含调用线程），默认为 CPU 逻辑核数；设为1时退化为单线程顺序执行
+    static void setMaxThreads(int threads);
+    static int maxThreads();
+};
+
+#endif // TILESCHEDULER_H
@@ -0,0 +1,291 @@
+#include "videoexporter.h"
+#include "videoprocessor.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMediaCaptureSession>
+#include <QMediaFormat>
+#include <QMediaMetaData>
+#include <QThread>
+#include <QVideoFrameInput>
+#include <QVideoSink>
+#include <QtConcurrent>
+
+VideoExporter::VideoExporter(const QUrl &source, const QList<ImageCommand *> &commands, QObject *parent)
+    : QObject(parent)
+    , m_commands(std::make_shared<const QList<ImageCommand *>>(commands))
+    , m_pool(2 * qMax(1, QThread::idealThreadCount()) + 8)
+{
+    // 排队上限：每个工作线程约两帧，既能让线程池满载，又限定了内存占用
+    m_maxQueued = 2 * qMax(1, QThread::idealThreadCount()) + 2;
+
+    m_player = new QMediaPlayer(this);
+    m_sink = new QVideoSink(this);
+    m_player->setVideoSink(m_sink);
+    m_player->setSource(source);
+
+    m_session = new QMediaCaptureSession(this);
+    m_input = new QVideoFrameInput(this);
+    m_recorder = new QMediaRecorder(this);
+    m_session->setVideoFrameInput(m_input);
+    m_session->setRecorder(m_recorder);
+
+    // 帧可能在解码线程中送达，排队到GUI线程，重排和背压状态无需加锁
+    connect(m_sink, &QVideoSink::videoFrameChanged, this, &VideoExporter::onFrame, Qt::QueuedConnection);
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &VideoExporter::onMediaStatusChanged);
+    connect(m_player, &QMediaPlayer::errorOccurred, this, [this](QMediaPlayer::Error, const QString &error) {
+        fail(tr("解码失败：%1").arg(error));
+    });
+    connect(m_input, &QVideoFrameInput::readyToSendVideoFrame, this, &VideoExporter::sendReadyFrames);
+    connect(m_recorder, &QMediaRecorder::errorOccurred, this, [this](QMediaRecorder::Error, const QString &error) {
+        fail(tr("编码失败：%1").arg(error));
+    });
+    connect(m_recorder, &QMediaRecorder::recorderStateChanged, this, [this](QMediaRecorder::RecorderState state) {
+        if (state != QMediaRecorder::StoppedState) return;
+        // 取消或失败后编码器才真正结束：此时文件已关闭，可以删除
+        if (!m_running) {
+            if (m_discard) removeOutput();
+            return;
+        }
+        if (!m_stopping) return;
+        m_running = false;
+        // 缺帧的文件不可用作成片，按失败处理
+        if (m_missing > 0) {
+            m_discard = true;
+            removeOutput();
+            emit finished(false, tr("解码时跳过了 %1 帧，已删除输出文件").arg(m_missing));
+            return;
+        }
+        emit finished(true, tr("已导出 %1 帧到 %2：%3 s，%4 帧/s")
+                                .arg(m_written).arg(QFileInfo(m_outputPath).fileName())
+                                .arg(m_timer.elapsed() / 1000.0, 0, 'f', 1)
+                                .arg(framesPerSecond(), 0, 'f', 1));
+    });
+}
+
+VideoExporter::~VideoExporter()
+{
+    cancel();
+    for (QFutureWatcher<QVideoFrame> *watcher : std::as_const(m_watchers)) {
+        watcher->waitForFinished();
+    }
+    // 删除编码器使其关闭输出文件，再删除未写完的文件
+    if (m_discard) {
+        delete m_recorder;
+        m_recorder = nullptr;
+        removeOutput();
+    }
+}
+
+void VideoExporter::start(const QString &outputPath)
+{
+    if (m_running) return;
+    m_outputPath = outputPath;
+
+    const QString suffix = QFileInfo(outputPath).suffix().toLower();
+    QMediaFormat format;
+    if (suffix == "mov") {
+        format.setFileFormat(QMediaFormat::QuickTime);
+    } else if (suffix == "mkv") {
+        format.setFileFormat(QMediaFormat::Matroska);
+    } else if (suffix == "avi") {
+        format.setFileFormat(QMediaFormat::AVI);
+    } else {
+        format.setFileFormat(QMediaFormat::MPEG4);
+    }
+    format.setVideoCodec(suffix == "avi" ? QMediaFormat::VideoCodec::MPEG4 : QMediaFormat::VideoCodec::H264);
+    m_recorder->setMediaFormat(format);
+    m_recorder->setQuality(QMediaRecorder::HighQuality);
+    m_recorder->setOutputLocation(QUrl::fromLocalFile(outputPath));
+
+    m_running = true;
+    m_timer.start();
+    // 媒体加载完成（帧率等元数据可用）后开始编码和解码
+    if (m_player->mediaStatus() == QMediaPlayer::LoadedMedia) {
+        onMediaStatusChanged(QMediaPlayer::LoadedMedia);
+    }
+}
+
+void VideoExporter::cancel()
+{
+    if (!m_running) return;
+    stop();
+    emit finished(false, tr("导出已取消"));
+}
+
+void VideoExporter::stop()
+{
+    m_running = false;
+    m_stopping = true;
+    m_discard = true;
+    m_player->stop();
+    m_recorder->stop();
+    m_reorder.clear();
+    removeOutput();
+}
+
+void VideoExporter::removeOutput()
+{
+    const QString path = m_recorder && !m_recorder->actualLocation().isEmpty()
+                             ? m_recorder->actualLocation().toLocalFile()
+                             : m_outputPath;
+    if (!path.isEmpty()) QFile::remove(path);
+}
+
+bool VideoExporter::isRunning() const
+{
+    return m_running;
+}
+
+qint64 VideoExporter::framesWritten() const
+{
+    return m_written;
+}
+
+qint64 VideoExporter::framesMissing() const
+{
+    return m_missing;
+}
+
+double VideoExporter::framesPerSecond() const
+{
+    const qint64 ms = m_timer.elapsed();
+    return ms > 0 ? m_written * 1000.0 / ms : 0.0;
+}
+
+void VideoExporter::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (!m_running) return;
+
+    if (status == QMediaPlayer::LoadedMedia && m_recorder->recorderState() == QMediaRecorder::StoppedState
+        && !m_stopping) {
+        const qreal frameRate = m_player->metaData().value(QMediaMetaData::VideoFrameRate).toReal();
+        if (frameRate > 0) {
+            m_recorder->setVideoFrameRate(frameRate);
+            m_frameDuration = qRound64(1e6 / frameRate);
+        }
+        m_recorder->record();
+        m_player->setPlaybackRate(m_playbackRate);
+        m_player->play();
+    } else if (status == QMediaPlayer::EndOfMedia) {
+        m_endOfMedia = true;
+        finishIfDone();
+    } else if (status == QMediaPlayer::InvalidMedia) {
+        fail(tr("无法读取视频"));
+    }
+}
+
+// 解码出一帧：编号后提交到线程池处理
+void VideoExporter::onFrame(const QVideoFrame &frame)
+{
+    if (!m_running || m_stopping || !frame.isValid()) return;
+    if (frame.startTime() >= 0 && frame.startTime() <= m_lastStartTime) return;
+    detectGap(frame);
+    m_lastStartTime = frame.startTime();
+    m_position = frame.startTime() / 1000;
+
+    const qint64 sequence = m_nextSequence++;
+    QFutureWatcher<QVideoFrame> *watcher = new QFutureWatcher<QVideoFrame>(this);
+    m_watchers.append(watcher);
+    connect(watcher, &QFutureWatcher<QVideoFrame>::finished, this,
+            [this, watcher, sequence]() { onProcessed(watcher, sequence); });
+
+    const std::shared_ptr<const QList<ImageCommand *>> commands = m_commands;
+    FramePool *pool = &m_pool;
+    watcher->setFuture(QtConcurrent::run([frame, commands, pool]() {
+        return VideoProcessor::processFrame(frame, *commands, pool);
+    }));
+    updateBackpressure();
+}
+
+// 时间戳间隔超过一帧半即有帧被跳过：计数并降低播放速率；持续正常时逐步提高速率
+void VideoExporter::detectGap(const QVideoFrame &frame)
+{
+    if (m_lastStartTime < 0 || frame.startTime() < 0) return;
+    const qint64 duration = frame.endTime() > frame.startTime() ? frame.endTime() - frame.startTime()
+                                                                : m_frameDuration;
+    if (duration <= 0) return;
+
+    const qint64 missing = ((frame.startTime() - m_lastStartTime) * 2 + duration) / (2 * duration) - 1;
+    if (missing > 0) {
+        m_missing += missing;
+        m_cleanFrames = 0;
+        if (m_playbackRate > 1.0) {
+            m_playbackRate = qMax<qreal>(1.0, m_playbackRate / 2);
+            m_player->setPlaybackRate(m_playbackRate);
+        }
+        return;
+    }
+    if (++m_cleanFrames >= RampFrames && m_playbackRate < MaxPlaybackRate) {
+        m_cleanFrames = 0;
+        m_playbackRate = qMin(MaxPlaybackRate, m_playbackRate * 2);
+        m_player->setPlaybackRate(m_playbackRate);
+    }
+}
+
+// 一帧处理完成：进入重排缓冲，按序送出
+void VideoExporter::onProcessed(QFutureWatcher<QVideoFrame> *watcher, qint64 sequence)
+{
+    m_watchers.removeOne(watcher);
+    watcher->deleteLater();
+    if (!m_running) return;
+
+    const QVideoFrame frame = watcher->result();
+    if (!frame.isValid()) {
+        fail(tr("第 %1 帧处理失败").arg(sequence));
+        return;
+    }
+    m_reorder.emplace(sequence, frame);
+    sendReadyFrames();
+}
+
+void VideoExporter::sendReadyFrames()
+{
+    if (!m_running) return;
+
+    while (!m_reorder.empty() && m_reorder.begin()->first == m_nextToSend) {
+        // 编码器队列已满：保留在缓冲中，等 readyToSendVideoFrame 再送
+        if (!m_input->sendVideoFrame(m_reorder.begin()->second)) break;
+        m_reorder.erase(m_reorder.begin());
+        ++m_nextToSend;
+        ++m_written;
+    }
+
+    emit progressChanged(m_written, m_position, m_player->duration());
+    updateBackpressure();
+    finishIfDone();
+}
+
+int VideoExporter::queuedFrames() const
+{
+    return int(m_watchers.size() + qsizetype(m_reorder.size()));
+}
+
+void VideoExporter::updateBackpressure()
+{
+    if (!m_running || m_endOfMedia) return;
+
+    const int queued = queuedFrames();
+    if (!m_decodePaused && queued >= m_maxQueued) {
+        m_decodePaused = true;
+        m_cleanFrames = 0;  // 处理已是瓶颈，提高解码速率无益
+        m_player->pause();
+    } else if (m_decodePaused && queued <= m_maxQueued / 2) {
+        m_decodePaused = false;
+        m_player->play();
+    }
+}
+
+// 解码结束且全部帧已送入编码器时结束录制，编码器停止后报告结果
+void VideoExporter::finishIfDone()
+{
+    if (!m_running || m_stopping || !m_endOfMedia || queuedFrames() > 0) return;
+    m_stopping = true;
+    m_recorder->stop();
+}
+
+void VideoExporter::fail(const QString &message)
+{
+    if (!m_running) return;
+    stop();
+    emit finished(false, message);
+}
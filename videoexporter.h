@@ -0,0 +1,101 @@
+#ifndef VIDEOEXPORTER_H
+#define VIDEOEXPORTER_H
+
+#include <QObject>
+#include <QList>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QVideoFrame>
+#include <QMediaPlayer>
+#include <QMediaRecorder>
+#include <map>
+#include <memory>
+#include "framepool.h"
+#include "imagecommand.h"
+
+class QVideoSink;
+class QVideoFrameInput;
+class QMediaCaptureSession;
+
+// 离线导出：把命令链处理后的视频写入文件（不含音轨）
+// 解码：独立的 QMediaPlayer 不接音频输出，按播放速率向 QVideoSink 送帧（Qt Multimedia 没有逐帧拉取的解码接口）；
+//       从 1 倍速开始，连续 RampFrames 帧既无缺帧也未触发背压时速率加倍（不超过 MaxPlaybackRate），缺帧时减半；
+// 处理：各帧在线程池中并行执行命令链（与实时处理共用 VideoProcessor::processFrame），按解码顺序编号，
+//       完成的帧进入重排缓冲，按编号依次经 QVideoFrameInput 送入 QMediaCaptureSession + QMediaRecorder 编码；
+// 背压：处理中、待重排和等待编码器的帧总数达到上限时暂停解码，降到一半以下时继续；
+//       编码器队列满（sendVideoFrame 返回 false）时等待 readyToSendVideoFrame 再送
+// 丢帧：处理跟不上时播放器会跳过帧。按时间戳间隔与帧时长检测缺失的帧；
+//       有缺帧的导出视为失败：删除输出文件，缺失的帧数在 finished(false, ...) 中报告
+// 取消或失败时发出 finished(false, ...) 并删除未写完的输出文件
+// 命令由调用者持有，导出期间不得删除
+class VideoExporter final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(VideoExporter)
+
+public:
+    static constexpr qreal MaxPlaybackRate = 16.0;
+    static constexpr int RampFrames = 120;  // 连续多少帧正常后提高播放速率
+
+    VideoExporter(const QUrl &source, const QList<ImageCommand *> &commands, QObject *parent = nullptr);
+    ~VideoExporter() override;  // 取消（发出 finished）并等待处理中的帧
+
+    // 开始导出；按后缀选择容器（mp4/mov/mkv/avi），视频编码为 H.264（avi 为 MPEG-4）
+    void start(const QString &outputPath);
+    void cancel();
+    bool isRunning() const;
+
+    qint64 framesWritten() const;
+    qint64 framesMissing() const;    // 解码时被跳过的帧数
+    double framesPerSecond() const;  // 自开始以来的平均写入速度
+
+signals:
+    void progressChanged(qint64 frames, qint64 position, qint64 duration);
+    void finished(bool ok, const QString &message);
+
+private:
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onFrame(const QVideoFrame &frame);
+    void onProcessed(QFutureWatcher<QVideoFrame> *watcher, qint64 sequence);
+    void sendReadyFrames();    // 按编号把重排缓冲中连续的帧送入编码器
+    void updateBackpressure(); // 按排队帧数暂停/继续解码
+    void finishIfDone();
+    void fail(const QString &message);
+    void stop();                 // 停止解码和编码，丢弃未送出的帧
+    void removeOutput();         // 删除未写完的输出文件
+    void detectGap(const QVideoFrame &frame);  // 与上一帧比较时间戳，统计缺失的帧
+    int queuedFrames() const;
+
+    QMediaPlayer *m_player = nullptr;
+    QVideoSink *m_sink = nullptr;
+    QMediaCaptureSession *m_session = nullptr;
+    QVideoFrameInput *m_input = nullptr;
+    QMediaRecorder *m_recorder = nullptr;
+
+    std::shared_ptr<const QList<ImageCommand *>> m_commands;
+    FramePool m_pool;
+    int m_maxQueued = 0;
+
+    QList<QFutureWatcher<QVideoFrame> *> m_watchers;  // 处理中的帧
+    std::map<qint64, QVideoFrame> m_reorder;          // 已处理、等待按序送入编码器的帧
+    qint64 m_nextSequence = 0;
+    qint64 m_nextToSend = 0;
+    qint64 m_lastStartTime = -1;  // 暂停/继续时播放器可能重复送出同一帧
+    qint64 m_frameDuration = 0;   // 由帧率得到的帧时长（微秒），帧自身不带结束时间时使用
+    qint64 m_written = 0;
+    qint64 m_missing = 0;
+    qreal m_playbackRate = 1.0;
+    int m_cleanFrames = 0;        // 自上次缺帧、背压暂停或调速以来的帧数
+    qint64 m_position = 0;
+
+    bool m_running = false;
+    bool m_decodePaused = false;
+    bool m_endOfMedia = false;
+    bool m_stopping = false;  // 已请求编码器结束
+    bool m_discard = false;   // 取消或失败：编码器结束后删除输出文件
+    QString m_outputPath;
+    QElapsedTimer m_timer;
+};
+
+#endif // VIDEOEXPORTER_H
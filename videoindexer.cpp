@@ -0,0 +1,334 @@
+#include "videoindexer.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUrl>
+#include <QVideoSink>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+constexpr quint32 IndexMagic = 0x50535649;  // "PSVI"
+constexpr quint32 IndexVersion = 3;  // 版本1可能缓存了不完整的索引，版本2的缩略图条为单行
+
+// 缩略图在缩略图条中的位置：从左到右排列，超出 MaxStripWidth 时换行（每行高 rowHeight）
+QList<QPoint> stripLayout(const QList<qint32> &widths, int rowHeight)
+{
+    QList<QPoint> positions;
+    int x = 0;
+    int y = 0;
+    for (const qint32 width : widths) {
+        if (x > 0 && x + width > VideoIndex::MaxStripWidth) {
+            x = 0;
+            y += rowHeight;
+        }
+        positions.append(QPoint(x, y));
+        x += width;
+    }
+    return positions;
+}
+
+} // namespace
+
+int VideoIndex::nearest(qint64 ms) const
+{
+    if (m_timestamps.isEmpty()) return -1;
+    const auto it = std::lower_bound(m_timestamps.cbegin(), m_timestamps.cend(), ms);
+    if (it == m_timestamps.cend()) return count() - 1;
+    const int i = int(it - m_timestamps.cbegin());
+    if (i > 0 && ms - m_timestamps[i - 1] < *it - ms) return i - 1;
+    return i;
+}
+
+void VideoIndex::insert(qint64 ms, const QImage &thumbnail)
+{
+    const auto it = std::lower_bound(m_timestamps.cbegin(), m_timestamps.cend(), ms);
+    const int i = int(it - m_timestamps.cbegin());
+    if (it != m_timestamps.cend() && *it == ms) {
+        m_thumbnails[i] = thumbnail;
+        return;
+    }
+    m_timestamps.insert(i, ms);
+    m_thumbnails.insert(i, thumbnail);
+}
+
+// 缩略图逐行拼成一张图片整体 JPEG 压缩，比逐张保存小且读写一次完成
+bool VideoIndex::save(const QString &path) const
+{
+    if (isEmpty()) return false;
+
+    QList<qint32> widths;
+    qint32 rowHeight = 1;
+    for (const QImage &thumbnail : m_thumbnails) {
+        widths.append(thumbnail.width());
+        rowHeight = qMax(rowHeight, qint32(thumbnail.height()));
+    }
+    const QList<QPoint> positions = stripLayout(widths, rowHeight);
+    int stripWidth = 1;
+    for (qsizetype i = 0; i < positions.size(); ++i) {
+        stripWidth = qMax(stripWidth, positions[i].x() + widths[i]);
+    }
+    QImage strip(stripWidth, positions.last().y() + rowHeight, QImage::Format_RGB32);
+    strip.fill(Qt::black);
+    {
+        QPainter painter(&strip);
+        for (qsizetype i = 0; i < positions.size(); ++i) {
+            painter.drawImage(positions[i], m_thumbnails[i]);
+        }
+    }
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    if (!strip.save(&buffer, "JPG", 85)) return false;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << IndexMagic << IndexVersion << m_timestamps << widths << rowHeight << m_missing << jpeg;
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+VideoIndex VideoIndex::load(const QString &path)
+{
+    VideoIndex index;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return index;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QList<qint64> timestamps;
+    QList<qint32> widths;
+    qint32 rowHeight = 0;
+    QList<qint64> missing;
+    QByteArray jpeg;
+    stream >> magic >> version;
+    if (magic != IndexMagic || version != IndexVersion) return index;
+    stream >> timestamps >> widths >> rowHeight >> missing >> jpeg;
+    if (stream.status() != QDataStream::Ok || timestamps.size() != widths.size() || rowHeight <= 0) return index;
+
+    const QImage strip = QImage::fromData(jpeg, "JPG");
+    if (strip.isNull()) return index;
+    const QList<QPoint> positions = stripLayout(widths, rowHeight);
+    for (qsizetype i = 0; i < timestamps.size(); ++i) {
+        index.m_timestamps.append(timestamps[i]);
+        index.m_thumbnails.append(strip.copy(QRect(positions[i], QSize(widths[i], rowHeight))));
+    }
+    index.m_missing = missing;
+    return index;
+}
+
+QString VideoIndex::cacheKey(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+
+    const QFileInfo info(filePath);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint64 size = file.size();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    hash.addData(QByteArrayView(reinterpret_cast<const char *>(&size), sizeof(size)));
+    hash.addData(QByteArrayView(reinterpret_cast<const char *>(&modified), sizeof(modified)));
+    hash.addData(file.read(HashBytes));
+    if (size > HashBytes) {
+        file.seek(qMax(HashBytes, size - HashBytes));
+        hash.addData(file.read(HashBytes));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString VideoIndex::cachePath(const QString &filePath)
+{
+    const QString key = cacheKey(filePath);
+    if (key.isEmpty()) return QString();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/video-index/" + key + ".psvidx";
+}
+
+VideoIndexer::VideoIndexer(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+{
+}
+
+// 等待后台的缓存读写和缩略图转换结束
+VideoIndexer::~VideoIndexer()
+{
+    for (QFutureWatcherBase *watcher : std::as_const(m_watchers)) {
+        watcher->waitForFinished();
+    }
+}
+
+// 在线程池中计算缓存键并读取缓存，命中时直接完成，否则开始建立索引
+void VideoIndexer::start()
+{
+    using Cached = std::pair<QString, VideoIndex>;
+    QFutureWatcher<Cached> *watcher = new QFutureWatcher<Cached>(this);
+    m_watchers.append(watcher);
+    connect(watcher, &QFutureWatcher<Cached>::finished, this, [this, watcher]() {
+        m_watchers.removeOne(watcher);
+        watcher->deleteLater();
+        const Cached cached = watcher->result();
+        m_cachePath = cached.first;
+        if (!cached.second.isEmpty()) {
+            m_index = cached.second;
+            emit updated();
+            if (m_index.isComplete()) {
+                m_finished = true;
+                emit finished();
+                return;
+            }
+        }
+        build();
+    });
+    const QString filePath = m_filePath;
+    watcher->setFuture(QtConcurrent::run([filePath]() {
+        const QString path = VideoIndex::cachePath(filePath);
+        return Cached(path, path.isEmpty() ? VideoIndex() : VideoIndex::load(path));
+    }));
+}
+
+bool VideoIndexer::isFinished() const
+{
+    return m_finished;
+}
+
+const VideoIndex &VideoIndexer::index() const
+{
+    return m_index;
+}
+
+// 独立的播放器只用于定位取帧，不接音频输出，也不影响窗口中的播放
+void VideoIndexer::build()
+{
+    m_player = new QMediaPlayer(this);
+    m_sink = new QVideoSink(this);
+    m_player->setVideoSink(m_sink);
+
+    m_timeout = new QTimer(this);
+    m_timeout->setSingleShot(true);
+    m_timeout->setInterval(SeekTimeoutMs);
+    connect(m_timeout, &QTimer::timeout, this, [this]() {
+        m_waiting = false;
+        m_missing.append(m_targets[m_next]);
+        ++m_next;
+        seekNext();
+    });
+
+    // 帧可能在解码线程中送达，排队到GUI线程处理
+    connect(m_sink, &QVideoSink::videoFrameChanged, this, &VideoIndexer::onFrame, Qt::QueuedConnection);
+    connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &VideoIndexer::onMediaStatusChanged);
+    connect(m_player, &QMediaPlayer::errorOccurred, this, [this]() { finish(); });
+    m_player->setSource(QUrl::fromLocalFile(m_filePath));
+}
+
+// 时长可用后在 [0, 时长) 内均匀分布采样点（缓存的索引有缺失时只取缺失的采样点），暂停状态下逐个定位
+void VideoIndexer::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (status == QMediaPlayer::InvalidMedia) {
+        finish();
+        return;
+    }
+    if (status != QMediaPlayer::LoadedMedia || !m_targets.isEmpty() || m_finished) return;
+
+    const qint64 duration = m_player->duration();
+    if (duration <= 0) {
+        finish();
+        return;
+    }
+    if (!m_index.isComplete()) {
+        m_targets = m_index.missing();
+    } else {
+        const int count = int(qBound<qint64>(1, duration / MinSpacingMs, MaxThumbnails));
+        for (int i = 0; i < count; ++i) {
+            m_targets.append(duration * i / count);
+        }
+    }
+    m_player->pause();
+    seekNext();
+}
+
+void VideoIndexer::seekNext()
+{
+    if (m_finished) return;
+    if (m_next >= m_targets.size()) {
+        finish();
+        return;
+    }
+    m_waiting = true;
+    m_seekFrameTime = m_lastFrameTime;
+    m_player->setPosition(m_targets[m_next]);
+    m_timeout->start();
+}
+
+// 定位后的第一个新帧：在线程池中缩小为缩略图，完成后定位下一个采样点
+void VideoIndexer::onFrame(const QVideoFrame &frame)
+{
+    if (!frame.isValid()) return;
+    m_lastFrameTime = frame.startTime();
+    if (!m_waiting || frame.startTime() == m_seekFrameTime) return;
+    m_waiting = false;
+    m_timeout->stop();
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    m_watchers.append(watcher);
+    const qint64 ms = frame.startTime() >= 0 ? frame.startTime() / 1000 : m_targets[m_next];
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, ms]() {
+        m_watchers.removeOne(watcher);
+        watcher->deleteLater();
+        const QImage thumbnail = watcher->result();
+        if (!thumbnail.isNull()) {
+            m_index.insert(ms, thumbnail);
+            emit updated();
+        } else {
+            m_missing.append(m_targets[m_next]);
+        }
+        ++m_next;
+        seekNext();
+    });
+    watcher->setFuture(QtConcurrent::run([frame]() {
+        return frame.toImage().scaledToHeight(VideoIndex::ThumbnailHeight, Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_RGB32);
+    }));
+}
+
+// 建立结束：释放播放器；遍历完全部采样点时索引连同跳过的采样点在后台写入磁盘缓存，
+// 出错中止时不写入，下次打开重新建立（缓存中记录的缺失采样点下次只重试这些）
+void VideoIndexer::finish()
+{
+    if (m_finished) return;
+    const bool traversed = !m_targets.isEmpty() && m_next >= m_targets.size();
+    if (traversed) m_index.setMissing(m_missing);
+    m_finished = true;
+    if (m_timeout) m_timeout->stop();
+    if (m_player) {
+        m_player->stop();
+        m_player->deleteLater();
+        m_player = nullptr;
+    }
+
+    if (traversed && !m_index.isEmpty() && !m_cachePath.isEmpty()) {
+        QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+        m_watchers.append(watcher);
+        connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher]() {
+            m_watchers.removeOne(watcher);
+            watcher->deleteLater();
+        });
+        const VideoIndex index = m_index;
+        const QString path = m_cachePath;
+        watcher->setFuture(QtConcurrent::run([index, path]() { index.save(path); }));
+    }
+    emit finished();
+}
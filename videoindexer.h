@@ -0,0 +1,102 @@
+#ifndef VIDEOINDEXER_H
+#define VIDEOINDEXER_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QVideoFrame>
+#include <QMediaPlayer>
+#include <QFutureWatcher>
+
+class QVideoSink;
+class QTimer;
+
+// 视频缩略图索引：按时间排序的实际帧时间戳（毫秒）和对应的小尺寸缩略图，以及未取到帧的采样点
+// 磁盘缓存为一个文件：文件头 + 时间戳表 + 缺失的采样点 + 全部缩略图拼接成的一张 JPEG 缩略图条
+// （逐行排列，每行不超过 MaxStripWidth，避免超出 JPEG 65535 像素的尺寸上限）
+class VideoIndex
+{
+public:
+    static constexpr int ThumbnailHeight = 90;
+    static constexpr int MaxStripWidth = 8192;
+
+    bool isEmpty() const { return m_timestamps.isEmpty(); }
+    int count() const { return int(m_timestamps.size()); }
+    qint64 timestamp(int i) const { return m_timestamps[i]; }
+    QImage thumbnail(int i) const { return m_thumbnails[i]; }
+
+    // 时间上最接近 ms 的缩略图序号（二分查找），索引为空时返回 -1
+    int nearest(qint64 ms) const;
+    // 按时间戳插入（保持有序）
+    void insert(qint64 ms, const QImage &thumbnail);
+
+    // 建立时超时或转换失败的采样点（毫秒）；为空表示索引完整，否则下次打开时只重试这些采样点
+    QList<qint64> missing() const { return m_missing; }
+    void setMissing(const QList<qint64> &missing) { m_missing = missing; }
+    bool isComplete() const { return m_missing.isEmpty(); }
+
+    bool save(const QString &path) const;
+    static VideoIndex load(const QString &path);
+
+    // 缓存位置：<缓存目录>/video-index/<键>.psvidx
+    // 键为文件大小、修改时间以及文件首尾各 HashBytes 字节的 SHA-1（不读整个文件，长视频也能立即算出）
+    static constexpr qint64 HashBytes = 64 * 1024;
+    static QString cacheKey(const QString &filePath);
+    static QString cachePath(const QString &filePath);
+
+private:
+    QList<qint64> m_timestamps;
+    QList<QImage> m_thumbnails;
+    QList<qint64> m_missing;
+};
+
+// 后台建立视频的缩略图索引：先查磁盘缓存，未命中时用独立的播放器（暂停状态）依次定位到均匀分布的采样点，
+// 取定位后送出的第一帧缩小为缩略图（转换在线程池中进行），记录帧的实际时间戳；
+// 遍历完全部采样点后写入缓存，跳过的采样点一并记录，缓存中有缺失时先使用已有部分，再只重试缺失的采样点
+// 建立过程中每得到一张缩略图就发出 updated()，已有的部分索引即可使用
+class VideoIndexer final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(VideoIndexer)
+
+public:
+    static constexpr int MaxThumbnails = 240;   // 采样点上限
+    static constexpr qint64 MinSpacingMs = 1000; // 采样点最小间隔
+    static constexpr int SeekTimeoutMs = 3000;  // 定位后等待帧的超时，超时跳过该采样点
+
+    explicit VideoIndexer(const QString &filePath, QObject *parent = nullptr);
+    ~VideoIndexer() override;
+
+    void start();
+    bool isFinished() const;
+    const VideoIndex &index() const;
+
+signals:
+    void updated();
+    void finished();
+
+private:
+    void build();
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onFrame(const QVideoFrame &frame);
+    void seekNext();
+    void finish();
+
+    QString m_filePath;
+    QString m_cachePath;
+    VideoIndex m_index;
+    QMediaPlayer *m_player = nullptr;
+    QVideoSink *m_sink = nullptr;
+    QTimer *m_timeout = nullptr;
+    QList<qint64> m_targets;  // 采样点（毫秒）
+    int m_next = 0;
+    QList<qint64> m_missing;          // 超时或转换失败而跳过的采样点
+    bool m_waiting = false;           // 已定位，等待该采样点的帧
+    qint64 m_lastFrameTime = -1;      // 最近收到的帧的时间戳（微秒），用于排除定位前的旧帧
+    qint64 m_seekFrameTime = -1;
+    bool m_finished = false;
+    QList<QFutureWatcherBase *> m_watchers;
+};
+
+#endif // VIDEOINDEXER_H
@@ -0,0 +1,270 @@
+#include "videoprocessor.h"
+#include "perftrace.h"
+#include "pixelview.h"
+#include "pointoperation.h"
+#include <QElapsedTimer>
+#include <QVideoFrameFormat>
+#include <QtConcurrent>
+#include <cstring>
+#include <optional>
+
+namespace {
+
+// 首个平面为8位亮度（Y）的格式
+bool hasLumaPlane(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_IMC1:
+    case QVideoFrameFormat::Format_IMC2:
+    case QVideoFrameFormat::Format_IMC3:
+    case QVideoFrameFormat::Format_IMC4:
+    case QVideoFrameFormat::Format_Y8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 有限范围亮度（16~235）展开到 0~255
+const PointOperation::LookupTable &videoRangeTable()
+{
+    static const PointOperation::LookupTable table = [] {
+        PointOperation::LookupTable t;
+        for (int i = 0; i < 256; ++i) {
+            t[i] = uchar(qBound(0, ((i - 16) * 255 + 109) / 219, 255));
+        }
+        return t;
+    }();
+    return table;
+}
+
+// 结果仍指向映射的源帧内存时（如恒等运算）复制到缓冲池，解除映射后依然有效
+QImage detachFromFrame(const QImage &result, const QImage &input, FramePool *pool)
+{
+    if (result.constBits() != input.constBits()) return result;
+
+    QImage copy = pool->acquire(result.size(), result.format());
+    if (copy.isNull()) return result.copy();
+    const qsizetype rowBytes = qMin(result.bytesPerLine(), copy.bytesPerLine());
+    for (int y = 0; y < result.height(); ++y) {
+        std::memcpy(copy.scanLine(y), result.constScanLine(y), size_t(rowBytes));
+    }
+    return copy;
+}
+
+} // namespace
+
+VideoProcessor::VideoProcessor(QVideoSink *output, QObject *parent)
+    : QObject(parent)
+    , m_input(new QVideoSink(this))
+    , m_output(output)
+    , m_chain(std::make_shared<const Chain>())
+{
+    // 帧可能在解码线程中送达，排队到本对象所在的GUI线程处理，计数无需加锁
+    connect(m_input, &QVideoSink::videoFrameChanged, this, &VideoProcessor::onFrame, Qt::QueuedConnection);
+}
+
+VideoProcessor::~VideoProcessor()
+{
+    waitForIdle();
+}
+
+QVideoSink *VideoProcessor::inputSink() const
+{
+    return m_input;
+}
+
+void VideoProcessor::setCommands(const QList<ImageCommand *> &commands)
+{
+    // 处理中的帧继续持有旧命令链的快照
+    m_chain = std::make_shared<const Chain>(commands);
+    if (m_lastFrame.isValid()) {
+        onFrame(m_lastFrame);
+    }
+}
+
+void VideoProcessor::clear()
+{
+    m_lastFrame = QVideoFrame();
+    m_pending = QVideoFrame();
+    // 处理中的帧完成后按“早于已显示帧”丢弃
+    m_presentedSequence = m_nextSequence - 1;
+}
+
+void VideoProcessor::waitForIdle()
+{
+    for (QFutureWatcher<Result> *watcher : std::as_const(m_watchers)) {
+        watcher->waitForFinished();
+    }
+}
+
+qint64 VideoProcessor::presentedFrames() const
+{
+    return m_presented;
+}
+
+qint64 VideoProcessor::droppedFrames() const
+{
+    return m_dropped;
+}
+
+double VideoProcessor::lastFrameMs() const
+{
+    return m_lastMs;
+}
+
+double VideoProcessor::averageFrameMs() const
+{
+    return m_averageMs;
+}
+
+void VideoProcessor::resetStatistics()
+{
+    m_presented = 0;
+    m_dropped = 0;
+    m_lastMs = 0.0;
+    m_averageMs = 0.0;
+    emit statisticsChanged();
+}
+
+// 新帧到达：有空闲处理槽时立即提交，否则替换等待中的帧（被替换的计为丢帧）
+void VideoProcessor::onFrame(const QVideoFrame &frame)
+{
+    if (!frame.isValid()) return;
+    m_lastFrame = frame;
+
+    const qint64 sequence = m_nextSequence++;
+    if (m_watchers.size() < MaxInFlight) {
+        submit(frame, sequence);
+        return;
+    }
+    if (m_pending.isValid()) {
+        ++m_dropped;
+        emit statisticsChanged();
+    }
+    m_pending = frame;
+    m_pendingSequence = sequence;
+}
+
+void VideoProcessor::submit(const QVideoFrame &frame, qint64 sequence)
+{
+    QFutureWatcher<Result> *watcher = new QFutureWatcher<Result>(this);
+    m_watchers.append(watcher);
+    connect(watcher, &QFutureWatcher<Result>::finished, this, [this, watcher]() { onFinished(watcher); });
+    watcher->setFuture(QtConcurrent::run(&VideoProcessor::process, frame, sequence, m_chain, &m_pool));
+}
+
+// 帧处理完成：按序显示，早于已显示帧的结果丢弃；空出的处理槽交给等待中的帧
+void VideoProcessor::onFinished(QFutureWatcher<Result> *watcher)
+{
+    m_watchers.removeOne(watcher);
+    watcher->deleteLater();
+    const Result result = watcher->result();
+
+    if (result.sequence > m_presentedSequence && result.frame.isValid()) {
+        m_presentedSequence = result.sequence;
+        if (m_output) m_output->setVideoFrame(result.frame);
+        ++m_presented;
+        m_lastMs = result.nsecs / 1e6;
+        m_averageMs = m_presented == 1 ? m_lastMs : m_averageMs * 0.9 + m_lastMs * 0.1;
+    } else {
+        ++m_dropped;
+    }
+    emit statisticsChanged();
+
+    if (m_pending.isValid()) {
+        const QVideoFrame frame = m_pending;
+        m_pending = QVideoFrame();
+        submit(frame, m_pendingSequence);
+    }
+}
+
+// 工作线程：处理一帧并计时
+VideoProcessor::Result VideoProcessor::process(const QVideoFrame &frame, qint64 sequence,
+                                               const std::shared_ptr<const Chain> &chain, FramePool *pool)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.sequence = sequence;
+    result.frame = processFrame(frame, *chain, pool);
+    result.nsecs = timer.nsecsElapsed();
+    return result;
+}
+
+// 帧只读映射后在原始平面上处理，不支持的格式转为规范处理格式后执行命令链
+QVideoFrame VideoProcessor::processFrame(const QVideoFrame &frame, const QList<ImageCommand *> &commands,
+                                         FramePool *pool)
+{
+    PerfTrace::Scope trace("VideoProcessor::processFrame", PerfTrace::megapixels(frame.size()));
+
+    QImage processed;
+    QVideoFrame mapped = frame;
+    if (mapped.map(QVideoFrame::ReadOnly)) {
+        processed = processMapped(mapped, commands, pool);
+        mapped.unmap();
+    }
+    if (processed.isNull()) {
+        const QImage image = PixelView::toCanonical(frame.toImage());
+        if (image.isNull()) return QVideoFrame();
+        processed = commands.isEmpty() ? image : ImageCommand::applyChain(commands, image, pool);
+    }
+
+    QVideoFrame result(processed);
+    result.setStartTime(frame.startTime());
+    result.setEndTime(frame.endTime());
+    return result;
+}
+
+// 在映射的平面上执行命令链；帧格式无法直接包装时返回空图像
+QImage VideoProcessor::processMapped(const QVideoFrame &mapped, const Chain &chain, FramePool *pool)
+{
+    const QVideoFrameFormat::PixelFormat pixelFormat = mapped.pixelFormat();
+    const int width = mapped.width();
+    const int height = mapped.height();
+
+    // 只读包装（const 缓冲区），命令写入时会另行分配，不会改动源帧
+    QImage input;
+    bool videoRange = false;
+    if (!chain.isEmpty() && chain.first()->readsGrayOnly() && hasLumaPlane(pixelFormat)) {
+        input = QImage(mapped.bits(0), width, height, mapped.bytesPerLine(0), QImage::Format_Grayscale8);
+        // 亮度平面与 (R+G+B)/3 灰度略有差异，有限范围（含未标明范围的 YUV）先展开到全范围
+        videoRange = pixelFormat != QVideoFrameFormat::Format_Y8
+                     && mapped.surfaceFormat().colorRange() != QVideoFrameFormat::ColorRange_Full;
+    } else {
+        const QImage::Format format = QVideoFrameFormat::imageFormatFromPixelFormat(pixelFormat);
+        if (format != QImage::Format_ARGB32 && format != QImage::Format_RGB32) return QImage();
+        input = QImage(mapped.bits(0), width, height, mapped.bytesPerLine(0), format);
+    }
+
+    // 全为点运算：与亮度展开合成一张表，单遍写入缓冲池的输出缓冲区
+    std::optional<PointOperation> fused;
+    if (videoRange) fused = PointOperation::lookup(videoRangeTable());
+    bool pointOnly = true;
+    for (const ImageCommand *command : chain) {
+        const std::optional<PointOperation> op = command->pointOperation();
+        if (!op) {
+            pointOnly = false;
+            break;
+        }
+        fused = fused ? fused->then(*op) : *op;
+    }
+    if (pointOnly) {
+        const PointOperation op = fused.value_or(PointOperation());
+        QImage target = pool->acquire(input.size(), op.resultFormat(input));
+        return detachFromFrame(op.apply(input, std::move(target)), input, pool);
+    }
+
+    // 含邻域运算：亮度展开、各步的中间结果和最终结果都写入缓冲池（不支持预分配输出的命令自行分配）
+    if (videoRange) {
+        QImage expanded = pool->acquire(input.size(), QImage::Format_Grayscale8);
+        input = PointOperation::lookup(videoRangeTable()).apply(input, std::move(expanded));
+    }
+    return detachFromFrame(ImageCommand::applyChain(chain, input, pool), input, pool);
+}
@@ -0,0 +1,90 @@
+#ifndef VIDEOPROCESSOR_H
+#define VIDEOPROCESSOR_H
+
+#include <QObject>
+#include <QList>
+#include <QVideoFrame>
+#include <QVideoSink>
+#include <QFutureWatcher>
+#include <memory>
+#include "framepool.h"
+#include "imagecommand.h"
+
+// 视频播放的实时处理：播放器把解码帧送入 inputSink()，每帧在线程池中经 ImageCommand::applyChain 处理，
+// 结果保留原帧的时间戳后交给输出 sink（QVideoWidget::videoSink()）显示
+// 播放器按音频时钟送帧，处理完立即显示，因此画面相对声音只落后处理耗时；
+// 为避免延迟累积，同时处理的帧不超过 MaxInFlight，其余帧只保留最新一帧等待，被替换的帧计为丢帧；
+// 乱序完成的旧帧（比已显示的帧更早）也直接丢弃
+// 源帧只读映射后直接在原始平面上处理：命令链先归约为灰度时取 NV12/YUV420 等格式的亮度平面作为灰度输入，
+// 32位 RGB 帧直接包装为 QImage；其余格式退回 QVideoFrame::toImage()
+// 全为点运算的命令链（含有限范围亮度的展开）合成为一张查找表，从映射平面单遍写入缓冲池的输出缓冲区；
+// 含边缘检测、均值滤波等邻域运算时，各步经 ImageCommand::applyInto() 写入缓冲池的缓冲区
+// 命令由调用者持有，删除命令前须调用 waitForIdle()
+class VideoProcessor final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(VideoProcessor)
+
+public:
+    static constexpr int MaxInFlight = 2;
+
+    explicit VideoProcessor(QVideoSink *output, QObject *parent = nullptr);
+    ~VideoProcessor() override;  // 等待仍在处理的帧
+
+    QVideoSink *inputSink() const;
+
+    // 处理一帧（可在任意线程调用）：结果沿用源帧的时间戳，失败时返回无效帧；导出时也使用
+    static QVideoFrame processFrame(const QVideoFrame &frame, const QList<ImageCommand *> &commands,
+                                    FramePool *pool);
+
+    // 替换命令链并重新处理最近一帧（暂停时画面随之更新）
+    void setCommands(const QList<ImageCommand *> &commands);
+    // 丢弃最近一帧、等待中的帧和处理中的结果：处理器被旁路时调用，重新启用时不会显示旁路前的旧画面
+    void clear();
+    void waitForIdle();
+
+    // 统计：已显示帧数、丢帧数、最近一帧和平均（指数滑动）处理耗时
+    qint64 presentedFrames() const;
+    qint64 droppedFrames() const;
+    double lastFrameMs() const;
+    double averageFrameMs() const;
+    void resetStatistics();
+
+signals:
+    void statisticsChanged();
+
+private:
+    struct Result
+    {
+        QVideoFrame frame;
+        qint64 sequence = 0;
+        qint64 nsecs = 0;
+    };
+    using Chain = QList<ImageCommand *>;
+
+    void onFrame(const QVideoFrame &frame);
+    void submit(const QVideoFrame &frame, qint64 sequence);
+    void onFinished(QFutureWatcher<Result> *watcher);
+    static Result process(const QVideoFrame &frame, qint64 sequence,
+                          const std::shared_ptr<const Chain> &chain, FramePool *pool);
+    static QImage processMapped(const QVideoFrame &mapped, const Chain &chain, FramePool *pool);
+
+    QVideoSink *m_input = nullptr;
+    QVideoSink *m_output = nullptr;
+    std::shared_ptr<const Chain> m_chain;
+    FramePool m_pool;  // 展开的亮度平面、中间结果和输出帧的缓冲区，稳定播放时不再分配像素内存
+
+    QList<QFutureWatcher<Result> *> m_watchers;  // 处理中的帧
+    QVideoFrame m_pending;        // 等待处理的最新一帧
+    qint64 m_pendingSequence = 0;
+    QVideoFrame m_lastFrame;      // 最近收到的源帧，命令链变化时重新处理
+    qint64 m_nextSequence = 0;
+    qint64 m_presentedSequence = -1;
+
+    qint64 m_presented = 0;
+    qint64 m_dropped = 0;
+    double m_lastMs = 0.0;
+    double m_averageMs = 0.0;
+};
+
+#endif // VIDEOPROCESSOR_H